@@ -0,0 +1,16 @@
+#!/bin/sh
+# Checks of peri (make check)
+# Each check/NAME.peri is run by ./peri with the options written on its first line ("// peri: --jit"),
+# and what it writes (both outputs and the exit status) has to be the same as check/NAME.out.
+cd `dirname $0`/..
+fail=0
+for f in check/*.peri; do
+  opt=`sed -n '1s|^// peri:||p' $f`
+  ./peri $opt $f < /dev/null > check/out.tmp 2>&1
+  echo "exit $?" >> check/out.tmp
+  if cmp -s check/out.tmp ${f%.peri}.out; then echo "ok    $f"
+  else echo "FAIL  $f"; diff ${f%.peri}.out check/out.tmp | head -20; fail=1
+  fi
+done
+rm -f check/out.tmp
+exit $fail
@@ -21,9 +21,28 @@
 
 /* Main Function */
 int main(int argc, char *argv[]) {
-  if (argc == 1) { cout << "Usage: peri filename\n"; exit(1); }
-  convert_to_internalCode(argv[1]);
-  syntaxChk();
-  execute();
+  extern bool fusionRpt_F, jit_F, tierRpt_F, emitCpp_F, cache_F, lexRpt_F, lineBuf_F;
+  int n;
+
+  for (n = 1; n < argc && argv[n][0] == '-' && argv[n][1] == '-'; n++) {   //  Options
+    if (strcmp(argv[n], "--fusion-report") == 0) fusionRpt_F = true;       //  Report the superinstructions
+    else if (strcmp(argv[n], "--jit") == 0) jit_F = true;                  //  Native code of the hot functions
+    else if (strcmp(argv[n], "--tier-report") == 0) tierRpt_F = true;      //  Report the tier of each function
+    else if (strcmp(argv[n], "--emit-cpp") == 0) emitCpp_F = true;         //  Write the program in C++
+    else if (strcmp(argv[n], "--cache") == 0) cache_F = true;              //  Keep the converted program
+    else if (strcmp(argv[n], "--lex-report") == 0) lexRpt_F = true;        //  Report the front end
+    else if (strcmp(argv[n], "--line-buffered") == 0) lineBuf_F = true;    //  Write the output at every println
+    else { cout << "Unknown option: " << argv[n] << "\n"; exit(1); }
+  }
+  if (n >= argc) { cout << "Usage: peri [--fusion-report] [--jit] [--tier-report] [--emit-cpp] [--cache] [--lex-report] [--line-buffered] filename|-\n"; exit(1); }
+  if (strcmp(argv[n], "-") == 0) cache_F = false;   //  The source comes from the standard input
+  if (!cache_F || !load_cache(argv[n])) {   //  The cache of the same source is used as it is
+    convert_to_internalCode(argv[n]);
+    syntaxChk();
+    inline_calls();                  //  Small functions are expanded at their calls
+    if (cache_F) save_cache(argv[n]);
+  }
+  if (emitCpp_F) emit_cpp(argv[n]);  //  C++ source to the standard output
+  else execute();
   return 0;
 }
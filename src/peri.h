@@ -20,24 +20,28 @@
 #include <fstream>  // File handling
 #include <sstream>  // String streams
 #include <string>
+#include <string_view>
 #include <vector>
+#include <map>
+#include <unordered_map>
 #include <stack>
+#include <algorithm>
 
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <cmath>
 #include <cctype>
+#include <climits>
 
 
 using namespace std;
 
 
 /* Define */
-#define SHORT_SIZ  sizeof(short int)      // Size of short int type
-#define SHORT_P(p) (short int *)(p)       // Convert to a pointer of short int type
+#define OPR_SIZ  sizeof(int)              // Size of the operand of a code (int32)
+#define OPR_P(p) (int *)(p)               // Convert to a pointer of the operand
 #define UCHAR_P(p) (unsigned char *)(p)   // Convert to a pointer of unsigned char type
-#define LIN_SIZ 255                       // Maximum size of one line of source
 
 
 /* Enum Struct of Token Kind */
@@ -48,10 +52,24 @@ enum TknKind {
   IntDivi='\\', Comma=',',     DblQ='"',
   Func=150, Var,   If,     Elif,   Else,   For, To, Step,  While,
   End,      Break, Return, Option, Print,  Println, Input, Toint,
-  Exit,     Equal, NotEq,  Less,   LessEq, Great,   GreatEq, And, Or,
+  Readarray, Loadarray, Storearray, Exit, Flush, Equal, NotEq,  Less,   LessEq, Great,   GreatEq, And, Or,
   END_KeyList,
   Ident,      IntNum, DblNum, String,   Letter, Doll, Digit,
-  Gvar, Lvar, Fcall,  EofProg, EofLine, Others
+  Gvar, Lvar, Fcall,  Uminus,
+  Gset, Lset, Gadrs,  Ladrs,  Jump,  JumpF, JumpT,  Pop,  Dup,  RetVal, ForChk, ForNext,
+  RetSet,                                                    //  Return value of an inline expansion
+  Gread, Lread, Gwrite, Lwrite,                              //  readarray, loadarray / storearray (array, file, format)
+  EofProg, EofLine,                                          //  Codes up to here are stored in one byte
+  LaddC, GaddC, CmpJF, CmpJT, AryCmpJF, AryCmpJT, RetIf,     //  Superinstructions (threaded code only)
+  I2D,  IPlus, IMinus, IMulti, IMod, IIntDivi, ILess, ILessEq, IGreat, IGreatEq, IEqual, INotEq,
+  IAnd, IOr,   INot,   IUminus, GvarI, LvarI, GadrsI, LadrsI, IPrint, IJumpF, IJumpT,
+  IForChk, IForNext, ICmpJF, ICmpJT, IAryCmpJF, IAryCmpJT, IRetIf,   //  On int64 (threaded code only)
+  ForChkUp, ForChkDn, ForNextUp, ForNextDn, IForChkUp, IForChkDn, IForNextUp, IForNextDn,   //  Counted loops
+  TailCall,                                                  //  Call that reuses the frame
+  GvarU, LvarU, GadrsU, LadrsU,                              //  Element by an int64 index proved to be in range
+  GvarA, LvarA, GsetA, LsetA,                                //  Scalar surely assigned, by its address (no check)
+  LoopJump,                                                  //  Jump back to the top of a 'while' (counted for the tiers)
+  Others
 };
 
 
@@ -59,15 +77,15 @@ enum TknKind {
 /* Token management */
 struct Token {
 
-  TknKind kind;     // Kind of Tokens
-  string  text;     // Text of Tokens
-  double  dblVal;   // Value in the case of numeric constants
+  TknKind kind;       // Kind of Tokens
+  string_view text;   // Text of Tokens (in the source in memory)
+  double  dblVal;     // Value in the case of numeric constants
 
   Token() {  kind = Others; text = ""; dblVal = 0.0; }
-  Token (TknKind k)                            { kind = k; text = ""; dblVal = 0.0; }
-  Token (TknKind k, double d)                  { kind = k; text = ""; dblVal = d; }
-  Token (TknKind k, const string& s)           { kind = k; text = s;  dblVal = 0.0; }
-  Token (TknKind k, const string& s, double d) { kind = k; text = s;  dblVal = d; }
+  Token (TknKind k)                         { kind = k; text = ""; dblVal = 0.0; }
+  Token (TknKind k, double d)               { kind = k; text = ""; dblVal = d; }
+  Token (TknKind k, string_view s)          { kind = k; text = s;  dblVal = 0.0; }
+  Token (TknKind k, string_view s, double d) { kind = k; text = s;  dblVal = d; }
 };
 
 
@@ -87,16 +105,25 @@ struct SymTbl {
   short   args;     //  Number of function arguments
   int     adrs;     //  Variable and function numbers
   int     frame;    //  Frame size for function
+  int     depth;    //  Maximum depth of the operand stack for function
+  long long calls;  //  Number of calls of function (tiers)
+  long long loops;  //  Number of the jumps back of the loops in function
+  char    tier;     //  0 : threaded code, not hot yet   1 : native code   -1 : stays threaded
 
   SymTbl() { clear(); }
 
   void clear() {
     name=""; nmKind=noId; dtTyp=NON_T;
-    aryLen=0; args=0; adrs=0; frame=0;
+    aryLen=0; args=0; adrs=0; frame=0; depth=0;
+    calls=0; loops=0; tier=0;
   }
 };
 
 
+/* Format of the elements in a file (readarray, loadarray, storearray) */
+enum ElmFmt { FMT_TEXT, FMT_F64, FMT_F32, FMT_I32, FMT_I64 };
+
+
 /* Code management */
 struct CodeSet {
 
@@ -105,13 +132,78 @@ struct CodeSet {
   double dblVal;      //  Value in the case of numeric constants
   int    symNbr;      //  Position of subscript in symbol table
   int    jmpAdrs;     //  Jumping address
+  int    fmt;         //  Format of the file (Gread, Lread, Gwrite, Lwrite)
 
   CodeSet() { clear(); }
   CodeSet(TknKind k)                    { clear(); kind = k; }
   CodeSet(TknKind k, double d)          { clear(); kind = k; dblVal = d; }
   CodeSet(TknKind k, const char *s)     { clear(); kind = k; text = s; }
   CodeSet(TknKind k, int sym, int jmp)  { clear(); kind = k; symNbr = sym; jmpAdrs = jmp; }
-  void clear() { kind=Others; text=""; dblVal=0.0; jmpAdrs=0; symNbr=-1; }
+  void clear() { kind=Others; text=""; dblVal=0.0; jmpAdrs=0; symNbr=-1; fmt=FMT_TEXT; }
+};
+
+
+/* Value in the memory and on the operand stack */
+/* Values that the type inference proves to be integers are held as int64. */
+union Value {
+
+  double    d;
+  long long i;
+};
+
+
+/* Range of a value for the type inference */
+struct Range {
+
+  bool   none;      //  No value has reached yet
+  bool   integer;   //  Always an integer in [lo, hi], held as int64
+  double lo, hi;
+
+  Range() { none = true; integer = false; lo = hi = 0; }
+};
+
+
+/* Value on the operand stack for the type inference */
+struct AbsVal {
+
+  Range r;          //  Range of the value (the address of the control variable of 'for' : the initial value)
+  int   prod;       //  Address of the code that made the value  -1 : argument
+  int   sym;        //  Variable whose address this is (Gadrs, Ladrs)   -1 : not an address
+  TknKind symKind;  //  Gvar or Lvar
+
+  AbsVal() { prod = -1; sym = -1; symKind = Gvar; }
+  AbsVal(const Range& rg, int p) { r = rg; prod = p; sym = -1; symKind = Gvar; }
+};
+
+
+/* Native code of a function (its argument is the frame in the main memory) */
+typedef void (*JitFnc)(Value *frame);
+#define HOT_COUNT 1000    //  Calls and jumps back of the loops that make a function hot (tiers)
+
+
+/* Entry of the cache of a memoized function */
+#define MEMO_ARGS 4       //  Functions with more arguments are not memoized
+struct MemoEnt {
+
+  bool   used;
+  Value  arg[MEMO_ARGS];  //  Arguments as they are
+  double val;             //  Return value
+
+  MemoEnt() { used = false; val = 0; }
+};
+
+
+/* Cell of the threaded code */
+/* A code is one cell, followed by one more cell for its operand if it has one. */
+union Icell {
+
+  void   *lbl;        //  Address of the handler (direct threading)
+  int     op;         //  Kind of code (switch dispatch)
+  int     n;          //  Symbol table No.
+  double  d;          //  Numeric literal
+  long long i;        //  Numeric literal held as int64
+  const char *s;      //  String literal
+  Icell  *jmp;        //  Jumping destination
 };
 
 
@@ -126,20 +218,25 @@ struct Tobj {
   Tobj(double dt)        { type = 'd'; d = dt;  s = ""; }
   Tobj(const string& st) { type = 's'; d = 0.0; s = st; }
   Tobj(const char *st)   { type = 's'; d = 0.0; s = st; }
+  Tobj(string_view st)   { type = 's'; d = 0.0; s = st; }
 };
 
 
 class Mymemory {
 
 private:
-  vector<double> mem;
+  vector<Value> mem;
 public:
   void auto_resize(int n) {   //  Secure more to reduce the number of re-securing
     if (n >= (int)mem.size()) { n = (n/256 + 1) * 256; mem.resize(n); }
   }
-  void set(int adrs, double dt) { mem[adrs] =  dt; }        //  Memory writing
-  void add(int adrs, double dt) { mem[adrs] += dt; }        //  Memory addition
-  double get(int adrs)          { return mem[adrs]; }       //  Memory reading
+  void set(int adrs, double dt) { mem[adrs].d =  dt; }      //  Memory writing
+  void add(int adrs, double dt) { mem[adrs].d += dt; }      //  Memory addition
+  double get(int adrs)          { return mem[adrs].d; }     //  Memory reading
+  void seti(int adrs, long long n) { mem[adrs].i =  n; }    //  int64 variables
+  void addi(int adrs, long long n) { mem[adrs].i += n; }
+  long long geti(int adrs)      { return mem[adrs].i; }
+  Value& at(int adrs)           { return mem[adrs]; }       //  Either type as it is
   int size()                    { return (int)mem.size(); } //  Storage size
   void resize(unsigned int n)   { mem.resize(n); }          //  Securing size
 
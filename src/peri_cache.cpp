@@ -0,0 +1,213 @@
+/********************************************************************************************************
+ *
+ *      PROJECT NAME    :   ASMI Demo Contest 2022
+ *
+ *      FILE NAME       :   peri_cache.cpp
+ *
+ *      OUTLINE         :   Cache of the converted program (--cache)
+ *
+ *      REQUIRED FILES  :   peri.h, peri_prot.h
+ *
+ *      EDITOR : Taichi KATO,   Advanced Sensing & Machine Intelligence Group,  Chukyo Univ.
+ *
+ *      LAST UPDATED : Apl. 17, 2022
+ *
+ *      Copyright © 2022 Taichi KATO. All rights reserved.
+ *
+*********************************************************************************************************/
+/* Header File */
+#include "peri.h"
+#include "peri_prot.h"
+
+#if defined(__unix__) || defined(__APPLE__)
+#define CACHE_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+/* Define */
+#define CACHE_MAGIC   "PERIC"   //  Head of the cache file
+#define CACHE_VERSION 5         //  Raised whenever the internal code or the tables change
+
+
+bool cache_F;                           //  If TRUE, use the cache of the converted program (--cache)
+unsigned long long srcHash;             //  Hash of the source (the key of the cache)
+vector<char> cacheBuf;                  //  Cache being made
+const char *cache_p, *cacheEnd;         //  Position in the cache being read
+extern vector<char> intercode;
+extern vector< pair<int,int> > srcLines;
+extern vector<SymTbl> Gtable;
+extern vector<SymTbl> Ltable;
+extern vector<string> strLITERAL;
+extern vector<double> nbrLITERAL;
+extern Mymemory Dmem;
+extern int startPc;
+extern int topDepth;
+extern bool memo_F;
+
+
+/* Cache */
+/* The program as it is after the conversion, syntaxChk() and inline_calls() is kept in "<source>c",
+   together with the hash of the source.  A later run whose source has the same hash maps the file
+   read-only and takes the tables from it, so the source is neither tokenized nor converted again.
+   A cache that cannot be used (another version, another source, broken) is simply made again. */
+bool load_cache(const char *fname) {
+#ifdef CACHE_MMAP
+  string cname = string(fname) + "c";
+  struct stat st;
+  void *p;
+  char magic[sizeof CACHE_MAGIC];
+  int fd, n, cnt, global;
+  bool ok;
+
+  if ((srcHash = source_hash(fname)) == 0) return false;
+  if ((fd = open(cname.c_str(), O_RDONLY)) < 0) return false;
+  if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+  p = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (p == MAP_FAILED) return false;
+  cache_p = (const char *)p; cacheEnd = cache_p + st.st_size;
+
+  ok = get_bytes(magic, sizeof magic) && memcmp(magic, CACHE_MAGIC, sizeof magic) == 0
+       && get_int() == CACHE_VERSION && get_u64() == srcHash;
+  if (ok) {
+    intercode.resize(cnt = get_count());
+    if (cnt > 0) get_bytes(&intercode[0], cnt);
+    srcLines.resize(cnt = get_count());
+    for (n = 0; n < cnt; n++) { srcLines[n].first = get_int(); srcLines[n].second = get_int(); }
+    get_table(Gtable); get_table(Ltable);
+    strLITERAL.resize(cnt = get_count());
+    for (n = 0; n < cnt; n++) strLITERAL[n] = get_str();
+    nbrLITERAL.resize(cnt = get_count());
+    for (n = 0; n < cnt; n++) get_bytes((char *)&nbrLITERAL[n], sizeof(double));
+    global = get_int(); startPc = get_int(); topDepth = get_int(); memo_F = get_int() != 0;
+    ok = cache_p == cacheEnd && global >= 0 && !intercode.empty();
+  }
+  munmap(p, st.st_size);
+  if (!ok) {                                            //  Back to the state before the load
+    intercode.clear(); srcLines.clear(); Gtable.clear(); Ltable.clear();
+    strLITERAL.clear(); nbrLITERAL.clear();
+    return false;
+  }
+  Dmem.resize(global);                                  //  Global area
+  return true;
+#else
+  return false;
+#endif
+}
+
+
+/* Keep the converted program ; the file is renamed into place, so a run reading it never sees half of it */
+void save_cache(const char *fname) {
+#ifdef CACHE_MMAP
+  string cname = string(fname) + "c", tmp;
+  ofstream fout;
+  int n;
+
+  cacheBuf.clear();
+  put_bytes(CACHE_MAGIC, sizeof CACHE_MAGIC);
+  put_int(CACHE_VERSION);
+  put_bytes((const char *)&srcHash, sizeof srcHash);
+  put_int(intercode.size()); put_bytes(&intercode[0], intercode.size());
+  put_int(srcLines.size());
+  for (n = 0; n < (int)srcLines.size(); n++) { put_int(srcLines[n].first); put_int(srcLines[n].second); }
+  put_table(Gtable); put_table(Ltable);
+  put_int(strLITERAL.size());
+  for (n = 0; n < (int)strLITERAL.size(); n++) put_str(strLITERAL[n]);
+  put_int(nbrLITERAL.size());
+  for (n = 0; n < (int)nbrLITERAL.size(); n++) put_bytes((const char *)&nbrLITERAL[n], sizeof(double));
+  put_int(Dmem.size()); put_int(startPc); put_int(topDepth); put_int(memo_F);
+
+  tmp = cname + "." + dbl_to_s(getpid());
+  fout.open(tmp.c_str(), ios::out | ios::binary);
+  if (!fout) return;                                    //  No cache if the directory is not writable
+  fout.write(&cacheBuf[0], cacheBuf.size());
+  fout.close();
+  if (!fout || rename(tmp.c_str(), cname.c_str()) != 0) remove(tmp.c_str());
+#endif
+}
+
+
+/* Hash of the source file (FNV-1a 64 bit) */
+unsigned long long source_hash(const char *fname) {
+  ifstream src(fname, ios::in | ios::binary);
+  unsigned long long h = 14695981039346656037ULL;
+  char b[4096];
+
+  if (!src) return 0;                                   //  The conversion reports it
+  while (src.read(b, sizeof b) || src.gcount() > 0) {
+    for (int n = 0; n < src.gcount(); n++) { h ^= (unsigned char)b[n]; h *= 1099511628211ULL; }
+  }
+  return h;
+}
+
+
+/* Writing into cacheBuf */
+void put_bytes(const char *s, int len) {
+  cacheBuf.insert(cacheBuf.end(), s, s + len);
+}
+
+void put_int(int n) {
+  put_bytes((const char *)&n, sizeof n);
+}
+
+void put_str(const string& s) {
+  put_int(s.size()); put_bytes(s.data(), s.size());
+}
+
+void put_table(const vector<SymTbl>& tbl) {
+  put_int(tbl.size());
+  for (int n = 0; n < (int)tbl.size(); n++) {
+    put_str(tbl[n].name);
+    put_int(tbl[n].nmKind); put_int(tbl[n].dtTyp); put_int(tbl[n].aryLen); put_int(tbl[n].args);
+    put_int(tbl[n].adrs);   put_int(tbl[n].frame); put_int(tbl[n].depth);
+  }
+}
+
+
+/* Reading from the mapped cache ; cache_p becomes NULL when the data runs out */
+bool get_bytes(char *s, int len) {
+  if (cache_p == NULL || len < 0 || cacheEnd - cache_p < len) { cache_p = NULL; return false; }
+  memcpy(s, cache_p, len); cache_p += len;
+  return true;
+}
+
+int get_int() {
+  int n = 0;
+  get_bytes((char *)&n, sizeof n);
+  return n;
+}
+
+int get_count() {                                       //  Number of items, not more than the bytes left
+  int n = get_int();
+  if (cache_p == NULL || n < 0 || n > cacheEnd - cache_p) { cache_p = NULL; return 0; }
+  return n;
+}
+
+unsigned long long get_u64() {
+  unsigned long long n = 0;
+  get_bytes((char *)&n, sizeof n);
+  return n;
+}
+
+string get_str() {
+  int len = get_int();
+  if (cache_p == NULL || len < 0 || cacheEnd - cache_p < len) { cache_p = NULL; return ""; }
+  cache_p += len;
+  return string(cache_p - len, len);
+}
+
+bool get_table(vector<SymTbl>& tbl) {
+  int cnt = get_count();
+
+  tbl.resize(cnt);
+  for (int n = 0; n < cnt && cache_p != NULL; n++) {
+    tbl[n].name = get_str();
+    tbl[n].nmKind = (SymKind)get_int(); tbl[n].dtTyp = get_int(); tbl[n].aryLen = get_int();
+    tbl[n].args = get_int(); tbl[n].adrs = get_int(); tbl[n].frame = get_int(); tbl[n].depth = get_int();
+  }
+  return cache_p != NULL;
+}
@@ -20,96 +20,190 @@
 #include "peri_prot.h"
 
 
-CodeSet code;                           //  Code Set 
-int startPc;                            //  Execution Start Line
-int Pc = -1;                            //  Program Counter   -1 : in progress
+int startPc;                            //  Execution Start Address
+int Pc = -1;                            //  Program Counter (address of the code)   -1 : in progress
 int baseReg;                            //  Base Register
 int spReg;                              //  Stack Pointer
-int maxLine;                            //  Program End Line
-vector<char*> intercode;                //  Converted Internal Code Storage
+int stkBaseReg;                         //  Operand stack size at the entry of the function
+vector<char> intercode;                 //  Converted Internal Code Storage (one contiguous image)
+vector< pair<int,int> > srcLines;       //  Code Address and Source Line No. of each statement
 char *code_ptr;                         //  Pointer for Internal Code Analysis
 double returnValue;                     //  Function's Return Value
-bool break_Flg, return_Flg, exit_Flg;   //  Controls Flags
+bool exit_Flg;                          //  Exit Flag
 Mymemory Dmem;                          //  Main Memory
 vector<string> strLITERAL;              //  String Literal Storage
 vector<double> nbrLITERAL;              //  Numerical Value Literal Storage
-bool syntaxChk_mode = false;            //  TRUE if Syntax Check System is ON
+unordered_map<string,int> strIndex;     //  Index of each string literal
+unordered_map<unsigned long long,int> nbrIndex;   //  Index of each number literal (by its bits)
 extern vector<SymTbl> Gtable;           //  Global Symbols Table
-
-
-/* Rapper of "stack<double>" */
+extern vector<SymTbl> Ltable;           //  Local Symbols Table
+extern vector<char> intCode;            //  The code works on int64 (type inference)
+extern vector<char> dblResult;          //  The int64 value made by the code is used as double
+extern vector<char> initVar;            //  The variable of the code has surely been assigned
+extern long long *loopCnt;              //  Counter of the jumps back for the next run() (tiers)
+extern vector<char> safeIdx;            //  The index of the array element is known to be in range
+extern vector<char> pureFnc;            //  The function is pure
+extern vector<JitFnc> jitFnc;           //  Native code of each function  NULL : interpreted
+extern vector< vector<char> > jitIntArg;    //  The parameter of the function is held as int64
+extern bool memo_F;                     //  Memoize the pure functions (option "memo")
+extern bool tierRpt_F;                  //  Report the tiers (--tier-report)
+
+
+/* Operand stack on one contiguous area */
+/* The depth needed is reserved in advance (syntaxChk() works it out), so push and pop are not checked. */
 class Mystack { 
 private:
-  stack<double> st;
+  vector<Value> st;
+  Value *sp;                            //  Next free position
 public:
-  void push(double n) { st.push(n); }   //  Pushing
-  int size() { return (int)st.size(); } //  Size
-  bool empty() { return st.empty(); }   //  Judge empty or not
-  double pop() {                        //  Pop & Delete (Caution! :Different from the original Pop)
-    if (st.empty()) err_exit("stack underflow");
-    double d = st.top();                //  Top value
-    st.pop(); return d;                 //  Delete one
+  Mystack() { st.resize(256); sp = &st[0]; }
+  void reserve(int n) {                 //  Secure n more elements
+    int used = sp - &st[0];
+    if (used + n > (int)st.size()) { st.resize((used + n) * 2); sp = &st[0] + used; }
   }
+  void push(double n) { (sp++)->d = n; }    //  Pushing
+  double pop() { return (--sp)->d; }    //  Pop & Delete (Caution! :Different from the original Pop)
+  double peek(int n) { return sp[-1-n].d; } //  n-th element from the top
+  void pushi(long long n) { (sp++)->i = n; }    //  int64 values
+  long long popi() { return (--sp)->i; }
+  long long peeki(int n) { return sp[-1-n].i; }
+  void pushv(const Value& v) { *sp++ = v; }     //  Either type as it is
+  Value popv() { return *--sp; }
+  Value peekv(int n) { return sp[-1-n]; }
+  void i2d() { sp[-1].d = (double)sp[-1].i; }   //  Convert the top from int64 to double
+  void resize(int n) { sp = &st[0] + n; }   //  Cut back to n elements
+  int size() { return sp - &st[0]; }    //  Size
+  bool empty() { return sp == &st[0]; } //  Judge empty or not
 };
 Mystack stk;                            //  Oporand Stack
+int topDepth;                           //  Operand stack depth for the code outside functions
+
+
+/* Threaded code */
+/* Before execution the internal code is translated into cells holding the address of each handler,
+   so the next code is reached by one indirect jump (direct threading).  With a compiler that cannot
+   take the address of a label, or if SWITCH_DISPATCH is defined, a switch is used instead. */
+#if defined(__GNUC__) && !defined(SWITCH_DISPATCH)
+#define THREADED_CODE
+#endif
+
+#ifdef THREADED_CODE
+#define CASE(kd)  L_##kd:
+#define NEXT      goto *pc->lbl
+#else
+#define CASE(kd)  case kd:
+#define NEXT      goto dispatch
+#endif
+#define SYNC_PC   (Pc = thrAdrs[pc - &thrCode[0]])    //  Address of the code, for error messages
+#define MEMO_SIZ  4096                  //  Entries of the cache of a memoized function
+
+vector<Icell> thrCode;                  //  Threaded Code
+vector<int> thrAdrs;                    //  Internal Code Address of each cell
+vector<Icell*> fncEntry;                //  Entry of each function (by the symbol table No.)
+Icell *thrStart;                        //  Execution Start Cell
+void **lblTbl;                          //  Handler of each code (direct threading)
+vector< pair<int,int> > thrFix;         //  Cell No. and Address of the jumps to be fixed
+vector< vector<MemoEnt> > memoTbl;      //  Cache of each memoized function (by the symbol table No.)
+int fusionCnt[RetIf-LaddC+1];           //  Number of each superinstruction
+bool fusionRpt_F;                       //  If TRUE, report the superinstructions
 
 
 /* Syntax Check */
+/* The internal code is followed along every jump to check the operand stack, and the maximum depth
+   is worked out for the code outside functions and for each function. */
 void syntaxChk() {
+  vector<int> depth(intercode.size(), -1);              //  Depth before each code  -1 : not reached
+
+  topDepth = chk_stkDepth(depth, 0, 0);
+  topDepth = max(topDepth, chk_stkDepth(depth, startPc, 0));
+  for (int n=0; n<(int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind == fncId)                      //  The arguments are on the stack at the entry
+      Gtable[n].depth = chk_stkDepth(depth, Gtable[n].adrs, Gtable[n].args);
+  }
+}
+
 
-  syntaxChk_mode = true;
+/* Maximum depth of the operand stack for the codes reached from "adrs", where the depth is n */
+int chk_stkDepth(vector<int>& depth, int adrs, int n) {
+  vector< pair<int,int> > branch;                       //  Branches left to follow (address, depth)
+  CodeSet cd;
+  int maxDepth = n, need, effect, next;
+  bool flow;
+
+  branch.push_back(make_pair(adrs, n));
+  while (!branch.empty()) {
+    adrs = branch.back().first; n = branch.back().second; branch.pop_back();
+    for (flow = true; flow; adrs = next) {
+      Pc = adrs;
+      if (depth[adrs] != -1) {                          //  Joined : the depth has to be the same
+        if (depth[adrs] != n) err_exit("Incorrect Expression");
+        break;
+      }
+      depth[adrs] = n;
+      code_ptr = &intercode[adrs]; cd = nextCode();
+      next = code_ptr - &intercode[0];
+
+      effect = stkEffect(cd, need);
+      if (n < need) err_exit("Incorrect Expression");
+      n += effect;
+      maxDepth = max(maxDepth, n);
+
+      switch (cd.kind) {                                //  Flow of control
+      case Jump: case Func: case ForNext:
+          next = cd.jmpAdrs;
+          break;
+      case JumpF: case JumpT: case ForChk:
+          branch.push_back(make_pair((int)cd.jmpAdrs, n));
+          break;
+      case Return: case Exit: case EofProg:
+          flow = false;
+          break;
+      }
+    }
+  }
+  return maxDepth;
+}
 
-  for (Pc=1; Pc<(int)intercode.size(); Pc++) {
 
-    code = firstCode(Pc);
+/* Change of the operand stack by the code ; "need" is the number of values it uses */
+int stkEffect(const CodeSet& cd, int& need) {
+  int ary = 0;
 
-    switch (code.kind) {
-    case Func: case Option: case Var:                       //  Already Checked
-      break;
-    case Else: case End: case Exit:
-      code = nextCode(); chk_EofLine();
-      break;
-    case If: case Elif: case While:
-      code = nextCode(); (void)get_expression(0, EofLine);  //  Expression Value
-      break;
-    case For:
-      code = nextCode();
-      (void)get_memAdrs(code);                              //  Control Variable Adress
-      (void)get_expression('=', 0);                         //  Initial Value
-      (void)get_expression(To, 0);                          //  Last    Value
-      if (code.kind == Step) (void)get_expression(Step,0);  //  Step    Value
-      chk_EofLine();
-      break;
-    case Fcall:                                             //  Function Calls without Assignments
-      fncCall_syntax(code.symNbr);
-      chk_EofLine();
-      (void)stk.pop();                                      //  No Return Value Required
-      break;
-    case Print: case Println:
-      sysFncExec_syntax(code.kind);
-      break;
-    case Gvar: case Lvar:                                   //  Assinnment Statements
-      (void)get_memAdrs(code);                              //  Left  Side Adress
-      (void)get_expression('=', EofLine);                   //  Right Side Expression Value
-      break;  
-    case Return:
-      code = nextCode(); 
-      if (code.kind!='?' && code.kind!=EofLine) (void)get_expression();   //  Return Value
-      if (code.kind == '?') (void)get_expression('?', 0);
-      chk_EofLine();
-      break;
-    case Break:
-      code = nextCode();
-      if (code.kind == '?') (void)get_expression('?', 0);
-      chk_EofLine();
-      break;
-    case EofLine:
+  switch (cd.kind) {
+  case Gvar: case Lvar: case Gset: case Lset: case Gadrs: case Ladrs:
+      ary = (tableP(cd)->aryLen != 0);                  //  The index or the address of an element
       break;
-    default:
-      err_exit("Incorrect Value : ", kind_to_s(code.kind));
-    }
   }
-  syntaxChk_mode = false;
+
+  switch (cd.kind) {
+  case IntNum: case DblNum: case Input: case RetVal: case Gread: case Lread: case Gwrite: case Lwrite:
+      need = 0; return 1;
+  case Gvar: case Lvar: case Gadrs: case Ladrs:         //  The index is replaced by the value or the address
+      need = ary; return 1 - ary;
+  case Gset: case Lset:
+      need = 1 + ary; return -1 - ary;
+  case Not: case Uminus: case Toint:
+      need = 1; return 0;
+  case Dup:
+      need = 1; return 1;
+  case Pop: case Print: case JumpF: case JumpT:
+      need = 1; return -1;
+  case Return: case RetSet:
+      need = 1; return 0;
+  case ForChk: case ForNext:                            //  Address, last value and step of the loop
+      need = 3; return 0;
+  case Fcall:                                           //  Arguments are replaced by the return value
+      need = Gtable[cd.symNbr].args; return 1 - need;
+  case Multi: case Divi: case Mod: case IntDivi: case Plus: case Minus:
+  case Less: case LessEq: case Great: case GreatEq: case Equal: case NotEq:
+  case And: case Or:
+      need = 2; return -1;
+  case String: case Println: case Flush: case Jump: case Func: case Exit: case EofProg:
+      need = 0; return 0;
+  default:
+      err_exit("Incorrect description: ", kind_to_s(cd.kind));
+  }
+  return 0;     //  Not in here
 }
 
 
@@ -124,549 +218,976 @@ void execute() {
   baseReg = 0;                      //  Base  Register's Initial Value
   spReg = Dmem.size();              //  Stack Register's Initial Value
   Dmem.resize(spReg+1000);          //  First Secure of Main Memory Area
-  break_Flg = return_Flg = exit_Flg = false;
+  stk.reserve(topDepth);            //  Operand stack for the code outside functions
+  exit_Flg = false;
 
   Pc = startPc;
-  maxLine = intercode.size() - 1;
-  while (Pc<=maxLine && !exit_Flg) {
-    statement();
-  }
+  thread_code();
+  run(thrStart);
+  out_flush();                      //  The rest of the output
   Pc = -1;                          //  Non-execute Mode
+  if (tierRpt_F) tier_report();
 }
 
 
-/* Statement, String */
-void statement() {
-  CodeSet save;
-  int top_line, end_line, varAdrs;
-  double wkVal, endDt, stepDt;
-
-  if (Pc > maxLine || exit_Flg) return;                   //  Program Terminations
-  code = save = firstCode(Pc);
-  top_line = Pc; end_line = code.jmpAdrs;                 //  Beginning and Termination of the Control Range
-  if (code.kind == If ) end_line = endline_of_If(Pc);     //  Termination for if statements
-
-  switch (code.kind) {
-  case If:                                                //  If
-    if (get_expression(If, 0)) {                          //  If TRUE, execute and exit.
-      ++Pc; block(); Pc = end_line + 1; 
-      return; 
+/* Translate the internal code into the threaded code */
+/* Frequent shapes of codes are fused into one superinstruction on the way (peephole optimization). */
+void thread_code() {
+  vector<CodeSet> cds;                                  //  Decoded codes
+  vector<int> adrs;                                     //  Address of each code
+  vector<int> target(intercode.size() + 1, 0);          //  Number of jumps to each address
+  vector<int> cell(intercode.size() + 1, -1);           //  Cell No. of each code address
+  vector<int> codeNo(intercode.size() + 1, -1);         //  Index in cds of each code address
+  vector<char> prologue(intercode.size() + 1, 0);       //  Lset of the parameters at a function entry
+  char *top = &intercode[0], *end = top + intercode.size();
+  int n, len;
+
+  run(NULL);                                            //  Get the handlers
+  infer_types();                                        //  Values held as int64
+  find_assigned();                                      //  Variables needing no check
+  for (code_ptr = top; code_ptr < end; ) {
+    codeNo[code_ptr - top] = cds.size();
+    adrs.push_back(code_ptr - top); cds.push_back(nextCode());
+    if (is_jump(cds.back().kind)) ++target[cds.back().jmpAdrs];
+  }
+  for (n = 0; n < (int)cds.size(); n++) {               //  Counted loops jump back to the top of the body
+    if (cds[n].kind == ForNext && for_step(cds, adrs, codeNo, n) >= 0) ++target[adrs[codeNo[cds[n].jmpAdrs] + 1]];
+  }
+  find_pure();                                          //  Memoized functions
+  memoTbl.assign(Gtable.size(), vector<MemoEnt>());
+  for (n = 0; n < (int)Gtable.size(); n++) {
+    if (memo_F && pureFnc[n] && Gtable[n].args <= MEMO_ARGS) memoTbl[n].resize(MEMO_SIZ);
+  }
+  for (n = 0; n < (int)Gtable.size(); n++) {            //  Parameters are stored by Fcall
+    if (Gtable[n].nmKind != fncId) continue;
+    for (int k = 0; k < Gtable[n].args; k++) {
+      prologue[Gtable[n].adrs + k * (1 + OPR_SIZ)] = 1;
+      Ltable[param_sym(n, k)].dtTyp = DBL_T;
     }
-    Pc = save.jmpAdrs;                                    //  Go Next...
-    while (lookCode(Pc) == Elif) {
-      save = firstCode(Pc); code = nextCode();
-      if (get_expression()) {                             //  If TRUE, execute and exit.
-        ++Pc; block(); Pc = end_line + 1;
-        return; 
-      }
-      Pc = save.jmpAdrs;                                  //  Go Next...
+    ++target[fnc_body(n)];
+  }
+  ++target[startPc];
+
+  thrCode.clear(); thrAdrs.clear(); thrFix.clear();
+  for (n = 0; n < (int)cds.size(); n += len) {
+    cell[adrs[n]] = thrCode.size();
+    if ((len = thr_fuse(cds, adrs, target, n)) != 0) continue;
+
+    len = 1;
+    if (prologue[adrs[n]]) continue;
+    if (thr_for(cds, adrs, codeNo, n)) continue;
+    if (cds[n].kind == Fcall && is_tailCall(cds, codeNo, n)) {   //  Memoized or not : the cache is at the outer call
+      thr_code(TailCall, adrs[n]); thr_int(cds[n].symNbr, adrs[n]);
+      continue;
     }
-    if (lookCode(Pc) == Else) {                           //  If TRUE, execute and exit.
-      ++Pc; block(); Pc = end_line + 1;
-      return; 
+    if (cds[n].kind == Toint && intCode[adrs[n]]) continue;   //  Already an integer in int
+    if (initVar[adrs[n]] && tableP(cds[n])->aryLen == 0) {   //  Straight to the memory
+      thr_code(direct_kind(cds[n].kind), adrs[n]); thr_int(tableP(cds[n])->adrs, adrs[n]);
+      if (dblResult[adrs[n]]) thr_code(I2D, adrs[n]);
+      continue;
     }
-    ++Pc;
-    break;
+    if (cds[n].kind == Jump && cds[n].jmpAdrs <= adrs[n]) {   //  Back edge of a 'while'
+      thr_code(LoopJump, adrs[n]); thr_jmp(cds[n].jmpAdrs, adrs[n]);
+      continue;
+    }
+    if (safeIdx[adrs[n]]) thr_code(unchecked_kind(cds[n].kind), adrs[n]);   //  No check of the index
+    else thr_code(intCode[adrs[n]] ? int_kind(cds[n].kind) : cds[n].kind, adrs[n]);
+    switch (cds[n].kind) {
+    case IntNum: case DblNum:
+        if (intCode[adrs[n]] && !dblResult[adrs[n]]) thr_i64((long long)cds[n].dblVal, adrs[n]);
+        else                                          thr_dbl(cds[n].dblVal, adrs[n]);
+        continue;
+    case String:
+        thr_str(cds[n].text, adrs[n]);
+        break;
+    case Fcall: case Gvar: case Lvar: case Gset: case Lset: case Gadrs: case Ladrs:
+        thr_int(cds[n].symNbr, adrs[n]);
+        break;
+    case Gread: case Lread: case Gwrite: case Lwrite:
+        thr_int(cds[n].symNbr, adrs[n]); thr_str(cds[n].text, adrs[n]); thr_int(cds[n].fmt, adrs[n]);
+        break;
+    default:
+        if (is_jump(cds[n].kind)) thr_jmp(cds[n].jmpAdrs, adrs[n]);
+        break;
+    }
+    if (dblResult[adrs[n]]) thr_code(I2D, adrs[n]);     //  The int64 value is used as double
+  }
 
-  case While:
-    for (;;) {
-      if (!get_expression(While, 0)) break;               //  False End
-      ++Pc; block();
-      if (break_Flg || return_Flg || exit_Flg) {
-        break_Flg = false; break;                         //  Break
-      }  
-      Pc = top_line; code = firstCode(Pc);                //  Go Head
-    } 
-    Pc = end_line + 1;
-    break;
+  for (n = 0; n < (int)thrFix.size(); n++) {            //  Jumping destinations
+    thrCode[thrFix[n].first].jmp = &thrCode[cell[thrFix[n].second]];
+  }
+  fncEntry.resize(Gtable.size());
+  for (n = 0; n < (int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind == fncId) fncEntry[n] = &thrCode[cell[fnc_body(n)]];
+  }
+  thrStart = &thrCode[cell[startPc]];
 
-  case For:
-    save = nextCode();
-    varAdrs = get_memAdrs(save);                          //  Get Control Variable Adress
-
-    expression('=', 0);                                   //  Initial Value
-    set_dtTyp(save, DBL_T);                               //  Determine Type
-    Dmem.set(varAdrs, stk.pop());                         //  Set Initial Value
-
-    endDt = get_expression(To, 0);                        //  Store the Last Value
-
-    if (code.kind == Step) stepDt = get_expression(Step, 0); else stepDt = 1.0;   //  Store the Step Value
-    for (;; Pc=top_line) { 
-      if (stepDt >= 0) {   
-        if (Dmem.get(varAdrs) > endDt) break;             //  if False, Break
-      } else { 
-        if (Dmem.get(varAdrs) < endDt) break;             //  if False, Break
-      } 
-      ++Pc; block();
-      if (break_Flg || return_Flg || exit_Flg) {
-        break_Flg = false; break;                         //  Break
-      } 
-      Dmem.add(varAdrs, stepDt);                          //  Update Value
-    } 
-    Pc = end_line + 1;
-    break;
+  jit_compile();                                        //  Ready for the native code of the hot functions (--jit)
+  if (fusionRpt_F) fusion_report();
+}
 
-  case Fcall:                                             //  Function Calls without Assignments
-    fncCall(code.symNbr);
-    (void)stk.pop();                                      //  No Return Value Required  
-    ++Pc;
-    break;
 
-  case Func:                                              //  Skipping Fuction Definition
-    Pc = end_line + 1;
-    break;
+/* Superinstruction for the codes from cds[n], returns the number of codes fused (0 : none) */
+/* The int64 ones are chosen where the type inference has made the codes int64. */
+int thr_fuse(const vector<CodeSet>& cds, const vector<int>& adrs, const vector<int>& target, int n) {
+  const CodeSet *c = &cds[n];
+  int rest = cds.size() - n, a = adrs[n];
+  bool isInt;
+
+  //  v = v + c , v = v - c     ->  LaddC/GaddC v c     (double variables)
+  if (rest >= 4 && (c[0].kind == Gvar || c[0].kind == Lvar) && tableP(c[0])->aryLen == 0
+      && !is_intVar(c[0].kind, c[0].symNbr)
+      && (c[1].kind == IntNum || c[1].kind == DblNum) && (c[2].kind == Plus || c[2].kind == Minus)
+      && c[3].kind == (c[0].kind == Gvar ? Gset : Lset) && c[3].symNbr == c[0].symNbr
+      && !target[adrs[n+1]] && !target[adrs[n+2]] && !target[adrs[n+3]]) {
+    thr_fused(c[0].kind == Gvar ? GaddC : LaddC, c[0].kind == Gvar ? GaddC : LaddC, a);
+    thr_int(c[0].symNbr, a);
+    thr_dbl(c[2].kind == Plus ? c[1].dblVal : -c[1].dblVal, a);
+    return 4;
+  }
 
-  case Print: case Println:
-    sysFncExec(code.kind);
-    ++Pc;
-    break;
+  //  a[index] cmp v  JumpF/JumpT   ->  AryCmpJF/AryCmpJT a v cmp
+  //  (a, v and the comparison are all double or all int64 ; the index may be either)
+  if (rest >= 4 && (c[0].kind == Gvar || c[0].kind == Lvar) && tableP(c[0])->aryLen != 0
+      && (((c[1].kind == Gvar || c[1].kind == Lvar) && tableP(c[1])->aryLen == 0
+           && is_intVar(c[1].kind, c[1].symNbr) == (bool)intCode[adrs[n+2]])
+          || ((c[1].kind == IntNum || c[1].kind == DblNum)
+              && (intCode[adrs[n+1]] && !dblResult[adrs[n+1]]) == (bool)intCode[adrs[n+2]]))
+      && is_compare(c[2].kind) && is_intVar(c[0].kind, c[0].symNbr) == (bool)intCode[adrs[n+2]]
+      && (c[3].kind == JumpF || c[3].kind == JumpT)
+      && !target[adrs[n+1]] && !target[adrs[n+2]] && !target[adrs[n+3]]) {
+    isInt = intCode[adrs[n+2]];
+    if (c[3].kind == JumpF) thr_fused(isInt ? IAryCmpJF : AryCmpJF, AryCmpJF, a);
+    else                    thr_fused(isInt ? IAryCmpJT : AryCmpJT, AryCmpJT, a);
+    if (safeIdx[a]) thr_int(unchecked_kind(c[0].kind), a);           //  GvarU, LvarU : no check of the index
+    else thr_int(intCode[a] ? int_kind(c[0].kind) : c[0].kind, a);   //  GvarI, LvarI : int64 index
+    thr_int(c[0].symNbr, a);
+    thr_int(c[1].kind, a);
+    if (c[1].kind == Gvar || c[1].kind == Lvar) thr_int(c[1].symNbr, a);
+    else if (isInt)                             thr_i64((long long)c[1].dblVal, a);
+    else                                        thr_dbl(c[1].dblVal, a);
+    thr_int(c[2].kind, a);
+    thr_jmp(c[3].jmpAdrs, a);
+    return 4;
+  }
 
-  case Gvar: case Lvar:                                   //  Assignment Statements
-    varAdrs = get_memAdrs(code);
-    expression('=', 0);
-    set_dtTyp(save, DBL_T);                               //  Determinate Type at Assignment
-    Dmem.set(varAdrs, stk.pop());
-    ++Pc;
-    break;
+  //  cmp JumpF/JumpT   ->  CmpJF/CmpJT cmp     (RetIf is left for the conditional return)
+  if (rest >= 2 && is_compare(c[0].kind) && (c[1].kind == JumpF || c[1].kind == JumpT)
+      && !target[adrs[n+1]] && !(rest >= 4 && c[2].kind == Return)) {
+    isInt = intCode[a];
+    if (c[1].kind == JumpF) thr_fused(isInt ? ICmpJF : CmpJF, CmpJF, a);
+    else                    thr_fused(isInt ? ICmpJT : CmpJT, CmpJT, a);
+    thr_int(c[0].kind, a);
+    thr_jmp(c[1].jmpAdrs, a);
+    return 2;
+  }
 
-  case Return:
-    wkVal = returnValue;
-    code = nextCode();
-    if (code.kind!='?' && code.kind!=EofLine)             //  If it has an Expression, calculate the return path.
-      wkVal = get_expression();
-    post_if_set(return_Flg);                              //  If it has a "?", process
-    if (return_Flg) returnValue = wkVal;
-    if (!return_Flg) ++Pc;
-    break;
+  //  JumpF L  Return  L: Pop   ->  RetIf     (return value ? condition)
+  if (rest >= 3 && c[0].kind == JumpF && c[1].kind == Return && c[2].kind == Pop
+      && c[0].jmpAdrs == adrs[n+2] && !target[adrs[n+1]] && target[adrs[n+2]] == 1) {
+    thr_fused(intCode[a] ? IRetIf : RetIf, RetIf, a);
+    return 3;
+  }
+  return 0;
+}
 
-  case Break:
-    code = nextCode(); post_if_set(break_Flg);            //  If it has a "?", process
-    if (!break_Flg) ++Pc;
-    break;
 
-  case Exit:
-    code = nextCode(); exit_Flg = true;
-    break;
+/* Address of the function body, after the Lset of the parameters */
+int fnc_body(int fncNbr) {
+  return Gtable[fncNbr].adrs + Gtable[fncNbr].args * (1 + OPR_SIZ);
+}
 
-  case Option: case Var: case EofLine:                    //  Ignored at Runtime
-    ++Pc;
-    break;
 
-  default:
-    err_exit("Incorrect description: ", kind_to_s(code.kind));
-  }
+/* TRUE if the call cds[n] is in tail position : its value is returned as it is */
+/* "return f()" is Fcall Return, and a call as the last statement is Fcall Pop RetVal Return, where
+   the return value left by the callee is returned.  Jumps to the end of the function are followed. */
+bool is_tailCall(const vector<CodeSet>& cds, const vector<int>& codeNo, int n) {
+  bool popped = false;
+  int jumps = 0;
+
+  if (++n < (int)cds.size() && cds[n].kind == Pop) { popped = true; ++n; }
+  while (n < (int)cds.size() && cds[n].kind == Jump && ++jumps < 16) n = codeNo[cds[n].jmpAdrs];
+  if (popped && n < (int)cds.size() && cds[n].kind == RetVal) ++n;
+  else if (popped) return false;
+  return n < (int)cds.size() && cds[n].kind == Return;
 }
 
 
-/* Execute the statement up to the end of the block */
-void block() {
-  TknKind k;
-  while (!break_Flg && !return_Flg && !exit_Flg) {    //  End at "break", "return", "exit" 
-    k = lookCode(Pc);                                 //  Next Initial Code
-    if (k==Elif || k==Else || k==End) break;          //  Block Successful Completion
-    statement();
+/* Counted loop with a constant step : the direction is chosen here, and ForNextUp and the like test
+   the end at the bottom of the loop and go straight back into the body, so ForChk runs only on entry */
+bool thr_for(const vector<CodeSet>& cds, const vector<int>& adrs, const vector<int>& codeNo, int n) {
+  int k = (cds[n].kind == ForNext) ? codeNo[cds[n].jmpAdrs] : n;      //  ForChk of the loop
+  int a = adrs[n];
+  bool isInt = intCode[a], up;
+  double step;
+
+  if (cds[n].kind != ForChk && cds[n].kind != ForNext) return false;
+  if (for_step(cds, adrs, codeNo, n) < 0) return false;
+  step = cds[k-1].dblVal; up = (step >= 0);
+
+  if (cds[n].kind == ForChk) {
+    if (isInt) thr_code(up ? IForChkUp : IForChkDn, a);
+    else       thr_code(up ? ForChkUp : ForChkDn, a);
+    thr_jmp(cds[n].jmpAdrs, a);
+    return true;
   }
+  if (isInt) thr_code(up ? IForNextUp : IForNextDn, a);
+  else       thr_code(up ? ForNextUp : ForNextDn, a);
+  thr_jmp(adrs[k+1], a);                                //  Top of the body
+  if (isInt) thr_i64((long long)step, a); else thr_dbl(step, a);
+  return true;
 }
 
 
-/* Set the following default arguments in the function declaration */
-//double get_expression(int kind1 = 0, int kind2 = 0)
-double get_expression(int kind1, int kind2) {   //  Expression to return the result
-  expression(kind1, kind2); return stk.pop();
+/* Index in cds of the constant step of the loop whose ForChk or ForNext is cds[n], -1 if it is not constant */
+/* The step is the last code before ForChk, and the exit of the loop must follow ForNext. */
+int for_step(const vector<CodeSet>& cds, const vector<int>& adrs, const vector<int>& codeNo, int n) {
+  int k = (cds[n].kind == ForNext) ? codeNo[cds[n].jmpAdrs] : n;
+
+  if (k < 1 || cds[k].kind != ForChk) return -1;
+  if (cds[k-1].kind != IntNum && cds[k-1].kind != DblNum) return -1;
+  if (cds[n].kind == ForNext && (n + 1 >= (int)cds.size() || cds[k].jmpAdrs != adrs[n+1])) return -1;
+  return k - 1;
 }
 
 
-/* Expression with Checking */
-void expression(int kind1, int kind2) {
-  if (kind1 != 0) code = chk_nextCode(code, kind1);
-  expression();
-  if (kind2 != 0) code = chk_nextCode(code, kind2);
+/* Code taking an int64 index without checking it for the code "kd" (an array element) */
+int unchecked_kind(TknKind kd) {
+  switch (kd) {
+  case Gvar:    return GvarU;    case Lvar:    return LvarU;
+  case Gadrs:   return GadrsU;   default:      return LadrsU;
+  }
 }
 
 
-/* Expression */
-void expression() {
-  term(1);
+/* Code using the address of a scalar surely assigned for the code "kd" (Gvar, Lvar, Gset, Lset) */
+int direct_kind(TknKind kd) {
+  switch (kd) {
+  case Gvar:    return GvarA;    case Lvar:    return LvarA;
+  case Gset:    return GsetA;    default:      return LsetA;
+  }
 }
 
 
-/* n is the Order of Priority */
-void term(int n) {
-  TknKind op;
-  if (n == 7) { factor(); return; }
-  term(n + 1);
-  while (n == opOrder(code.kind)) {   //  Followed by Operends of Equal Strength
-    op = code.kind;
-    code = nextCode(); term(n+1);
-    if (syntaxChk_mode) { stk.pop(); stk.pop(); stk.push(1.0); }  //  When Syntax Checking
-    else binaryExpr(op);
+/* Code working on int64 for the code "kd" */
+int int_kind(TknKind kd) {
+  switch (kd) {
+  case Plus:    return IPlus;    case Minus:   return IMinus;   case Multi:   return IMulti;
+  case Mod:     return IMod;     case IntDivi: return IIntDivi;
+  case Less:    return ILess;    case LessEq:  return ILessEq;  case Great:   return IGreat;
+  case GreatEq: return IGreatEq; case Equal:   return IEqual;   case NotEq:   return INotEq;
+  case And:     return IAnd;     case Or:      return IOr;      case Not:     return INot;
+  case Uminus:  return IUminus;  case Print:   return IPrint;
+  case Gvar:    return GvarI;    case Lvar:    return LvarI;
+  case Gadrs:   return GadrsI;   case Ladrs:   return LadrsI;
+  case JumpF:   return IJumpF;   case JumpT:   return IJumpT;
+  case ForChk:  return IForChk;  case ForNext: return IForNext;
+  default:      return kd;                              //  Literals : only the operand differs
   }
 }
 
 
-/* Factor */
-void factor() {                                                   //  When Syntax Checking
-  TknKind kd = code.kind;
-
-  if (syntaxChk_mode) {
-    switch (kd) {
-    case Not: case Minus: case Plus:
-        code = nextCode(); factor(); stk.pop(); stk.push(1.0);
-        break;
-    case Lparen:
-        expression('(', ')');
-        break;
-    case IntNum: case DblNum:
-        stk.push(1.0); code = nextCode();
-        break;
-    case Gvar: case Lvar:
-        (void)get_memAdrs(code); stk.push(1.0);
-        break;
-    case Toint: case Input:
-        sysFncExec_syntax(kd);
-        break;
-    case Fcall:
-        fncCall_syntax(code.symNbr);
-        break;
-    case EofLine:
-        err_exit("Incorrect Expression");
-    default:
-        err_exit("Expression Error:", kind_to_s(code));         //  Occurs for a, +, =, etc...
-    }
-    return;
+/* TRUE if the code has a jumping address */
+bool is_jump(TknKind kd) {
+  switch (kd) {
+  case Func: case Jump: case JumpF: case JumpT: case ForChk: case ForNext: return true;
+  default: return false;
   }
+}
 
-  /* Runtime */
-  switch (kd) { 
-  case Not: case Minus: case Plus:
-      code = nextCode(); factor();              //  Get next value and ...
-      if (kd == Not)   stk.push(!stk.pop());    //  ! Processing
-      if (kd == Minus) stk.push(-stk.pop());    //  - Processing
-      break;                                    //  If unary +, do nothing
-  case Lparen:
-      expression('(', ')');
-      break;
-  case IntNum: case DblNum:
-      stk.push(code.dblVal); code = nextCode();
-      break;
-  case Gvar: case Lvar:
-      chk_dtTyp(code);                          //  Check if the variable has been set to a value
-      stk.push(Dmem.get(get_memAdrs(code)));
-      break;
-  case Toint: case Input:
-      sysFncExec(kd);
-      break;
-  case Fcall:
-      fncCall(code.symNbr);
 
-      break;
+/* TRUE if the code is a comparison */
+bool is_compare(TknKind kd) {
+  switch (kd) {
+  case Less: case LessEq: case Great: case GreatEq: case Equal: case NotEq: return true;
+  default: return false;
   }
 }
 
 
-/* Precedence of Binary Operands */
-int opOrder(TknKind kd) {
-    switch (kd) {
-    case Multi: case Divi: case Mod:
-    case IntDivi:                    return 6;    //  * / % ¥
-    case Plus:  case Minus:          return 5;    //  + -
-    case Less:  case LessEq:
-    case Great: case GreatEq:        return 4;    //  < <=  > >=
-    case Equal: case NotEq:          return 3;    //  ==  !=
-    case And:                        return 2;    //  &&
-    case Or:                         return 1;    //  ||
-    default:                         return 0;    //  Not applicable
-    }
+/* Comparison of the fused codes */
+bool compare(int op, double d1, double d2) {
+  switch (op) {
+  case Less:    return d1 <  d2;
+  case LessEq:  return d1 <= d2;
+  case Great:   return d1 >  d2;
+  case GreatEq: return d1 >= d2;
+  case Equal:   return d1 == d2;
+  default:      return d1 != d2;
+  }
 }
 
+bool compare(int op, long long i1, long long i2) {
+  switch (op) {
+  case Less:    return i1 <  i2;
+  case LessEq:  return i1 <= i2;
+  case Great:   return i1 >  i2;
+  case GreatEq: return i1 >= i2;
+  case Equal:   return i1 == i2;
+  default:      return i1 != i2;
+  }
+}
 
-/* Binary Expression */
-void binaryExpr(TknKind op) {
-  double d = 0, d2 = stk.pop(), d1 = stk.pop();
 
-  if ((op == Divi || op == Mod || op == IntDivi) && d2==0)
-    err_exit("Division by Zero");
+/* Store the cells of the threaded code ("adrs" is the internal code address for error messages) */
+void thr_code(int kd, int adrs) {
+  Icell c;
+  if (lblTbl != NULL) c.lbl = lblTbl[kd]; else c.op = kd;
+  thrCode.push_back(c); thrAdrs.push_back(adrs);
+}
 
-  switch (op) {
-  case Plus:    d = d1 + d2;  break;
-  case Minus:   d = d1 - d2;  break;
-  case Multi:   d = d1 * d2;  break;
-  case Divi:    d = d1 / d2;  break;
-  case Mod:     d = (int)d1 % (int)d2; break;
-  case IntDivi: d = (int)d1 / (int)d2; break;
-  case Less:    d = d1 <  d2; break;
-  case LessEq:  d = d1 <= d2; break;
-  case Great:   d = d1 >  d2; break;
-  case GreatEq: d = d1 >= d2; break;
-  case Equal:   d = d1 == d2; break;
-  case NotEq:   d = d1 != d2; break;
-  case And:     d = d1 && d2; break;
-  case Or:      d = d1 || d2; break;
-  }
-  stk.push(d);
+void thr_fused(int kd, int base, int adrs) {            //  Superinstruction, counted by its double kind
+  thr_code(kd, adrs);
+  ++fusionCnt[base - LaddC];
+}
+
+void thr_int(int n, int adrs) {
+  Icell c; c.n = n;
+  thrCode.push_back(c); thrAdrs.push_back(adrs);
+}
+
+void thr_dbl(double d, int adrs) {
+  Icell c; c.d = d;
+  thrCode.push_back(c); thrAdrs.push_back(adrs);
 }
 
+void thr_i64(long long i, int adrs) {
+  Icell c; c.i = i;
+  thrCode.push_back(c); thrAdrs.push_back(adrs);
+}
 
-/* ? Expression */
-void post_if_set(bool& flg) {
-  if (code.kind == EofLine) { flg = true; return; }   //  TRUE for flg if there is no ?
-  if (get_expression('?', 0)) flg = true;             //  Processing with conditional expressions
+void thr_str(const char *s, int adrs) {
+  Icell c; c.s = s;
+  thrCode.push_back(c); thrAdrs.push_back(adrs);
 }
 
+void thr_jmp(int jmpAdrs, int adrs) {                   //  Fixed when all the cells are stored
+  Icell c; c.jmp = NULL;
+  thrFix.push_back(make_pair((int)thrCode.size(), jmpAdrs));
+  thrCode.push_back(c); thrAdrs.push_back(adrs);
+}
 
-/* Checking Function Call */
-void fncCall_syntax(int fncNbr) {
-  int argCt = 0;
 
-  code = nextCode(); code = chk_nextCode(code, '(');
-  if (code.kind != ')') {                       //  There are Arguments
-    for (;; code=nextCode()) {
-      (void)get_expression(); ++argCt;          //  Argument expression processing and argument count
-      if (code.kind != ',') break;              //  If there is a "," , argument follows.
-    }
+/* Report of the superinstructions */
+void fusion_report() {
+  const char *name[] = {
+    "LaddC    (local = local + constant)",
+    "GaddC    (global = global + constant)",
+    "CmpJF    (compare, jump if false)",
+    "CmpJT    (compare, jump if true)",
+    "AryCmpJF (compare array element, jump if false)",
+    "AryCmpJT (compare array element, jump if true)",
+    "RetIf    (return value ? condition)",
+  };
+  int total = 0;
+
+  cerr << "Fusion report" << endl;
+  for (int n = 0; n <= RetIf - LaddC; n++) {
+    cerr << "  " << name[n] << " : " << fusionCnt[n] << endl;
+    total += fusionCnt[n];
   }
-  code = chk_nextCode(code, ')');               //  It should be ")"
-  if (argCt != Gtable[fncNbr].args)             //  Checking the number of arguments
-    err_exit(Gtable[fncNbr].name, "The number of arguments for the function is wrong.");
-  stk.push(1.0);                                //  Push Safety Value
+  cerr << "  total : " << total << endl;
 }
 
 
-/* Function Call */
-void fncCall(int fncNbr) {
-  int  n, argCt = 0;
-  vector<double> vc;
+/* Execute the threaded code from "pc" up to return, exit or the end of the program */
+/* run(NULL) only sets the handler table */
+void run(Icell *pc) {
+  SymTbl *p;
+  double d, d2;
+  long long i, i2;
+  int adrs, index;
+  bool sense;
+  Value v;
+  string s;
+  long long *loops = loopCnt;                           //  Counter of the jumps back of the loops
+
+#ifdef THREADED_CODE
+  static void *lbl[Others+1];
+#define SET_LBL(kd) (lbl[kd] = &&L_##kd)
+  if (pc == NULL) {
+    for (int n=0; n<=Others; n++) lbl[n] = &&L_Others;
+    SET_LBL(IntNum); SET_LBL(DblNum); SET_LBL(String);
+    SET_LBL(Gvar);   SET_LBL(Lvar);   SET_LBL(Gset);  SET_LBL(Lset);  SET_LBL(Gadrs); SET_LBL(Ladrs);
+    SET_LBL(Plus);   SET_LBL(Minus);  SET_LBL(Multi); SET_LBL(Divi);  SET_LBL(Mod);   SET_LBL(IntDivi);
+    SET_LBL(Less);   SET_LBL(LessEq); SET_LBL(Great); SET_LBL(GreatEq);
+    SET_LBL(Equal);  SET_LBL(NotEq);  SET_LBL(And);   SET_LBL(Or);
+    SET_LBL(Not);    SET_LBL(Uminus); SET_LBL(Toint); SET_LBL(Input);
+    SET_LBL(Fcall);  SET_LBL(Func);   SET_LBL(Return);SET_LBL(RetVal);SET_LBL(Exit);  SET_LBL(EofProg);
+    SET_LBL(Jump);   SET_LBL(JumpF);  SET_LBL(JumpT); SET_LBL(ForChk);SET_LBL(ForNext);
+    SET_LBL(Pop);    SET_LBL(Dup);    SET_LBL(Print); SET_LBL(Println); SET_LBL(Flush);
+    SET_LBL(Gread);  SET_LBL(Lread);  SET_LBL(Gwrite);SET_LBL(Lwrite);
+    SET_LBL(LaddC);  SET_LBL(GaddC);  SET_LBL(CmpJF); SET_LBL(CmpJT);
+    SET_LBL(AryCmpJF); SET_LBL(AryCmpJT); SET_LBL(RetIf);
+    SET_LBL(I2D);    SET_LBL(IPlus);  SET_LBL(IMinus);SET_LBL(IMulti);SET_LBL(IMod);  SET_LBL(IIntDivi);
+    SET_LBL(ILess);  SET_LBL(ILessEq);SET_LBL(IGreat);SET_LBL(IGreatEq);
+    SET_LBL(IEqual); SET_LBL(INotEq); SET_LBL(IAnd);  SET_LBL(IOr);   SET_LBL(INot);  SET_LBL(IUminus);
+    SET_LBL(GvarI);  SET_LBL(LvarI);  SET_LBL(GadrsI);SET_LBL(LadrsI);SET_LBL(IPrint);
+    SET_LBL(IJumpF); SET_LBL(IJumpT); SET_LBL(IForChk);SET_LBL(IForNext);
+    SET_LBL(ICmpJF); SET_LBL(ICmpJT); SET_LBL(IAryCmpJF); SET_LBL(IAryCmpJT); SET_LBL(IRetIf);
+    SET_LBL(ForChkUp);  SET_LBL(ForChkDn);  SET_LBL(ForNextUp);  SET_LBL(ForNextDn);
+    SET_LBL(IForChkUp); SET_LBL(IForChkDn); SET_LBL(IForNextUp); SET_LBL(IForNextDn);
+    SET_LBL(TailCall); SET_LBL(RetSet);
+    SET_LBL(GvarU);  SET_LBL(LvarU);  SET_LBL(GadrsU);SET_LBL(LadrsU);
+    SET_LBL(GvarA);  SET_LBL(LvarA);  SET_LBL(GsetA); SET_LBL(LsetA);  SET_LBL(LoopJump);
+    lblTbl = lbl;
+    return;
+  }
+  NEXT;
+#else
+  if (pc == NULL) return;
+dispatch:
+  switch (pc->op) {
+#endif
+
+  CASE(IntNum) CASE(DblNum)                             //  Numeric literal (int64 or double as it is)
+    stk.pushi(pc[1].i);
+    pc += 2; NEXT;
+
+  CASE(Gvar)                                            //  Value of the variable (the index is on the stack)
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto load;
+  CASE(Lvar)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  load:
+    if (p->dtTyp == NON_T) { SYNC_PC; err_exit("An uninitialized variable has been used: ", p->name); }
+    if (p->aryLen != 0) {
+      d = stk.pop(); index = (int)d;
+      if (index != d || index < 0 || p->aryLen <= index) { SYNC_PC; chk_index(d, p->aryLen); }
+      adrs += index;
+    }
+    stk.pushv(Dmem.at(adrs));
+    pc += 2; NEXT;
+  CASE(GvarI)                                           //  Element of the array by an int64 index
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto loadi;
+  CASE(LvarI)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  loadi:
+    if (p->dtTyp == NON_T) { SYNC_PC; err_exit("An uninitialized variable has been used: ", p->name); }
+    i = stk.popi();
+    if (i < 0 || p->aryLen <= i) { SYNC_PC; chk_index((double)i, p->aryLen); }
+    stk.pushv(Dmem.at(adrs + (int)i));
+    pc += 2; NEXT;
+  CASE(GvarU)                                           //  Element by an int64 index known to be in range
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto loadu;
+  CASE(LvarU)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  loadu:
+    if (p->dtTyp == NON_T) { SYNC_PC; err_exit("An uninitialized variable has been used: ", p->name); }
+    adrs += (int)stk.popi();
+    stk.pushv(Dmem.at(adrs));
+    pc += 2; NEXT;
+
+  CASE(Gadrs)                                           //  Address of the variable or the array element
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto address;
+  CASE(Ladrs)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  address:
+    if (p->aryLen != 0) {
+      d = stk.pop(); index = (int)d;
+      if (index != d || index < 0 || p->aryLen <= index) { SYNC_PC; chk_index(d, p->aryLen); }
+      adrs += index;
+    }
+    stk.pushi(adrs);                                    //  Addresses are int64
+    pc += 2; NEXT;
+  CASE(GadrsI)
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto addressi;
+  CASE(LadrsI)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  addressi:
+    i = stk.popi();
+    if (i < 0 || p->aryLen <= i) { SYNC_PC; chk_index((double)i, p->aryLen); }
+    stk.pushi(adrs + (int)i);
+    pc += 2; NEXT;
+  CASE(GadrsU)
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto addressu;
+  CASE(LadrsU)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  addressu:
+    stk.pushi(adrs + stk.popi());
+    pc += 2; NEXT;
+
+  CASE(Gset)                                            //  Assignment (an element address is under the value)
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto store;
+  CASE(Lset)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  store:
+    if (p->dtTyp == NON_T) set_dtTyp(p, adrs, DBL_T);  //  Determinate Type at Assignment
+    v = stk.popv();                                     //  The variable has the type of the value
+    if (p->aryLen != 0) adrs = (int)stk.popi();
+    Dmem.at(adrs) = v;
+    pc += 2; NEXT;
+
+  CASE(GvarA)                                           //  Scalar surely assigned (pc[1] : memory address)
+    stk.pushv(Dmem.at(pc[1].n));
+    pc += 2; NEXT;
+  CASE(LvarA)                                           //  (pc[1] : address in the frame)
+    stk.pushv(Dmem.at(pc[1].n + baseReg));
+    pc += 2; NEXT;
+  CASE(GsetA)
+    Dmem.at(pc[1].n) = stk.popv();
+    pc += 2; NEXT;
+  CASE(LsetA)
+    Dmem.at(pc[1].n + baseReg) = stk.popv();
+    pc += 2; NEXT;
+
+  CASE(Plus)    d2 = stk.pop(); d = stk.pop(); stk.push(d + d2);  pc++; NEXT;
+  CASE(Minus)   d2 = stk.pop(); d = stk.pop(); stk.push(d - d2);  pc++; NEXT;
+  CASE(Multi)   d2 = stk.pop(); d = stk.pop(); stk.push(d * d2);  pc++; NEXT;
+  CASE(Less)    d2 = stk.pop(); d = stk.pop(); stk.push(d <  d2); pc++; NEXT;
+  CASE(LessEq)  d2 = stk.pop(); d = stk.pop(); stk.push(d <= d2); pc++; NEXT;
+  CASE(Great)   d2 = stk.pop(); d = stk.pop(); stk.push(d >  d2); pc++; NEXT;
+  CASE(GreatEq) d2 = stk.pop(); d = stk.pop(); stk.push(d >= d2); pc++; NEXT;
+  CASE(Equal)   d2 = stk.pop(); d = stk.pop(); stk.push(d == d2); pc++; NEXT;
+  CASE(NotEq)   d2 = stk.pop(); d = stk.pop(); stk.push(d != d2); pc++; NEXT;
+  CASE(And)     d2 = stk.pop(); d = stk.pop(); stk.push(d && d2); pc++; NEXT;
+  CASE(Or)      d2 = stk.pop(); d = stk.pop(); stk.push(d || d2); pc++; NEXT;
+  CASE(Divi)
+    d2 = stk.pop(); d = stk.pop();
+    if (d2 == 0) { SYNC_PC; err_exit("Division by Zero"); }
+    stk.push(d / d2);
+    pc++; NEXT;
+  CASE(Mod)
+    d2 = stk.pop(); d = stk.pop();
+    if (d2 == 0) { SYNC_PC; err_exit("Division by Zero"); }
+    stk.push((int)d % (int)d2);
+    pc++; NEXT;
+  CASE(IntDivi)
+    d2 = stk.pop(); d = stk.pop();
+    if (d2 == 0) { SYNC_PC; err_exit("Division by Zero"); }
+    stk.push((int)d / (int)d2);
+    pc++; NEXT;
+
+  CASE(Not)     stk.push(!stk.pop());      pc++; NEXT;
+  CASE(Uminus)  stk.push(-stk.pop());      pc++; NEXT;
+  CASE(Toint)   stk.pushi((int)stk.pop()); pc++; NEXT; //  Rounding down of fractions (always int64)
+
+  CASE(IPlus)    i2 = stk.popi(); i = stk.popi(); stk.pushi(i + i2);  pc++; NEXT;   //  On int64
+  CASE(IMinus)   i2 = stk.popi(); i = stk.popi(); stk.pushi(i - i2);  pc++; NEXT;
+  CASE(IMulti)   i2 = stk.popi(); i = stk.popi(); stk.pushi(i * i2);  pc++; NEXT;
+  CASE(ILess)    i2 = stk.popi(); i = stk.popi(); stk.pushi(i <  i2); pc++; NEXT;
+  CASE(ILessEq)  i2 = stk.popi(); i = stk.popi(); stk.pushi(i <= i2); pc++; NEXT;
+  CASE(IGreat)   i2 = stk.popi(); i = stk.popi(); stk.pushi(i >  i2); pc++; NEXT;
+  CASE(IGreatEq) i2 = stk.popi(); i = stk.popi(); stk.pushi(i >= i2); pc++; NEXT;
+  CASE(IEqual)   i2 = stk.popi(); i = stk.popi(); stk.pushi(i == i2); pc++; NEXT;
+  CASE(INotEq)   i2 = stk.popi(); i = stk.popi(); stk.pushi(i != i2); pc++; NEXT;
+  CASE(IAnd)     i2 = stk.popi(); i = stk.popi(); stk.pushi(i && i2); pc++; NEXT;
+  CASE(IOr)      i2 = stk.popi(); i = stk.popi(); stk.pushi(i || i2); pc++; NEXT;
+  CASE(IMod)
+    i2 = stk.popi(); i = stk.popi();
+    if (i2 == 0) { SYNC_PC; err_exit("Division by Zero"); }
+    stk.pushi((int)i % (int)i2);
+    pc++; NEXT;
+  CASE(IIntDivi)
+    i2 = stk.popi(); i = stk.popi();
+    if (i2 == 0) { SYNC_PC; err_exit("Division by Zero"); }
+    stk.pushi((int)i / (int)i2);
+    pc++; NEXT;
+  CASE(INot)     stk.pushi(!stk.popi());    pc++; NEXT;
+  CASE(IUminus)  stk.pushi(-stk.popi());    pc++; NEXT;
+  CASE(I2D)      stk.i2d();                 pc++; NEXT;
+  CASE(Input)
+    stk.push(in_line());                                //  Number on the next line
+    pc++; NEXT;
+  CASE(Gread)                                           //  readarray, loadarray (pc[2] : file name, pc[3] : format)
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto readary;
+  CASE(Lread)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  readary:
+    SYNC_PC;
+    if (p->dtTyp == NON_T) set_dtTyp(p, adrs, DBL_T);
+    if (pc[3].n == FMT_TEXT) stk.push(read_array(&Dmem.at(adrs), p->aryLen, pc[2].s));   //  The count read
+    else                     stk.push(load_array(&Dmem.at(adrs), p->aryLen, pc[2].s, pc[3].n));
+    pc += 4; NEXT;
+  CASE(Gwrite)                                          //  storearray
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto writeary;
+  CASE(Lwrite)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  writeary:
+    SYNC_PC;
+    if (p->dtTyp == NON_T) err_exit("An uninitialized variable has been used: ", p->name);
+    stk.push(store_array(&Dmem.at(adrs), p->aryLen, pc[2].s, pc[3].n));   //  The count written
+    pc += 4; NEXT;
+
+  CASE(Fcall)                                           //  The arguments have already been pushed in order
+    fncExec(pc[1].n);
+    if (exit_Flg) return;
+    pc += 2; NEXT;
+  CASE(TailCall)                                        //  The frame of the function is reused
+    p = &Gtable[pc[1].n];
+    spReg = baseReg + p->frame;
+    Dmem.auto_resize(spReg);
+    for (index = 0; index < p->args; index++) {
+      Dmem.at(baseReg + index) = stk.peekv(p->args - 1 - index);
+    }
+    stk.resize(stkBaseReg);
+    stk.reserve(p->depth);
+    returnValue = 1.0;
+    ++p->calls; loops = &p->loops;
+    pc = fncEntry[pc[1].n]; NEXT;
+  CASE(Func)                                            //  Skipping Fuction Definition
+    pc = pc[1].jmp; NEXT;
+  CASE(Return)
+    returnValue = stk.pop();
+    return;
+  CASE(RetSet)                                          //  Return value of an inline expansion (left on the stack)
+    returnValue = stk.peek(0);
+    pc++; NEXT;
+  CASE(RetVal)                                          //  The current return value
+    stk.push(returnValue);
+    pc++; NEXT;
+  CASE(Exit)
+    exit_Flg = true;
+    return;
+  CASE(EofProg)
+    return;
 
-  nextCode(); code = nextCode();    //  Function name   ( Skipping
-  if (code.kind != ')') {           //  There are Arguments
-    for (;; code=nextCode()) {
-      expression(); ++argCt;        //  Argument expression processing and argument count
-      if (code.kind != ',') break;  //  If there is a "," , argument follows.
+  CASE(Jump)
+    pc = pc[1].jmp; NEXT;
+  CASE(LoopJump)
+    ++*loops;
+    pc = pc[1].jmp; NEXT;
+  CASE(JumpF)
+    if (stk.pop()) pc += 2; else pc = pc[1].jmp;
+    NEXT;
+  CASE(JumpT)
+    if (stk.pop()) pc = pc[1].jmp; else pc += 2;
+    NEXT;
+  CASE(IJumpF)
+    if (stk.popi()) pc += 2; else pc = pc[1].jmp;
+    NEXT;
+  CASE(IJumpT)
+    if (stk.popi()) pc = pc[1].jmp; else pc += 2;
+    NEXT;
+  CASE(ForChk)                                          //  Stack : address, last value, step
+    d = Dmem.get((int)stk.peeki(2));
+    if (stk.peek(0) >= 0 ? d > stk.peek(1) : d < stk.peek(1)) pc = pc[1].jmp;   //  if False, Break
+    else pc += 2;
+    NEXT;
+  CASE(ForNext)
+    ++*loops;
+    Dmem.add((int)stk.peeki(2), stk.peek(0));            //  Update Value
+    pc = pc[1].jmp; NEXT;
+  CASE(IForChk)                                         //  The control variable is int64
+    i = Dmem.geti((int)stk.peeki(2));
+    if (stk.peeki(0) >= 0 ? i > stk.peeki(1) : i < stk.peeki(1)) pc = pc[1].jmp;
+    else pc += 2;
+    NEXT;
+  CASE(IForNext)
+    ++*loops;
+    Dmem.addi((int)stk.peeki(2), stk.peeki(0));
+    pc = pc[1].jmp; NEXT;
+
+  CASE(ForChkUp)                                        //  Counted loops (constant step)
+    if (Dmem.get((int)stk.peeki(2)) > stk.peek(1)) pc = pc[1].jmp; else pc += 2;
+    NEXT;
+  CASE(ForChkDn)
+    if (Dmem.get((int)stk.peeki(2)) < stk.peek(1)) pc = pc[1].jmp; else pc += 2;
+    NEXT;
+  CASE(ForNextUp)                                       //  Update, then test and go back into the body
+    ++*loops;
+    adrs = (int)stk.peeki(2); Dmem.add(adrs, pc[2].d);
+    if (Dmem.get(adrs) > stk.peek(1)) pc += 3; else pc = pc[1].jmp;
+    NEXT;
+  CASE(ForNextDn)
+    ++*loops;
+    adrs = (int)stk.peeki(2); Dmem.add(adrs, pc[2].d);
+    if (Dmem.get(adrs) < stk.peek(1)) pc += 3; else pc = pc[1].jmp;
+    NEXT;
+  CASE(IForChkUp)
+    if (Dmem.geti((int)stk.peeki(2)) > stk.peeki(1)) pc = pc[1].jmp; else pc += 2;
+    NEXT;
+  CASE(IForChkDn)
+    if (Dmem.geti((int)stk.peeki(2)) < stk.peeki(1)) pc = pc[1].jmp; else pc += 2;
+    NEXT;
+  CASE(IForNextUp)
+    ++*loops;
+    adrs = (int)stk.peeki(2); Dmem.addi(adrs, pc[2].i);
+    if (Dmem.geti(adrs) > stk.peeki(1)) pc += 3; else pc = pc[1].jmp;
+    NEXT;
+  CASE(IForNextDn)
+    ++*loops;
+    adrs = (int)stk.peeki(2); Dmem.addi(adrs, pc[2].i);
+    if (Dmem.geti(adrs) < stk.peeki(1)) pc += 3; else pc = pc[1].jmp;
+    NEXT;
+
+  CASE(GaddC)                                           //  Superinstructions
+    p = &Gtable[pc[1].n]; adrs = p->adrs;
+    goto addc;
+  CASE(LaddC)
+    p = &Ltable[pc[1].n]; adrs = p->adrs + baseReg;
+  addc:
+    if (p->dtTyp == NON_T) { SYNC_PC; err_exit("An uninitialized variable has been used: ", p->name); }
+    Dmem.add(adrs, pc[2].d);
+    pc += 3; NEXT;
+  CASE(CmpJF)
+    d2 = stk.pop(); d = stk.pop();
+    if (compare(pc[1].n, d, d2)) pc += 3; else pc = pc[2].jmp;
+    NEXT;
+  CASE(CmpJT)
+    d2 = stk.pop(); d = stk.pop();
+    if (compare(pc[1].n, d, d2)) pc = pc[2].jmp; else pc += 3;
+    NEXT;
+  CASE(ICmpJF)
+    i2 = stk.popi(); i = stk.popi();
+    if (compare(pc[1].n, i, i2)) pc += 3; else pc = pc[2].jmp;
+    NEXT;
+  CASE(ICmpJT)
+    i2 = stk.popi(); i = stk.popi();
+    if (compare(pc[1].n, i, i2)) pc = pc[2].jmp; else pc += 3;
+    NEXT;
+  CASE(AryCmpJT)                                        //  a[index] cmp v
+    sense = true;
+    goto arycmp;
+  CASE(AryCmpJF)
+    sense = false;
+  arycmp:
+    adrs = ary_element(pc);
+    if (adrs < 0) { SYNC_PC; ary_error(pc); }
+    d = Dmem.get(adrs);
+    if (pc[3].n == Gvar || pc[3].n == Lvar) {
+      p = (pc[3].n == Gvar) ? &Gtable[pc[4].n] : &Ltable[pc[4].n];
+      if (p->dtTyp == NON_T) { SYNC_PC; err_exit("An uninitialized variable has been used: ", p->name); }
+      d2 = Dmem.get(p->adrs + (pc[3].n == Gvar ? 0 : baseReg));
+    }
+    else d2 = pc[4].d;
+    if (compare(pc[5].n, d, d2) == sense) pc = pc[6].jmp; else pc += 7;
+    NEXT;
+  CASE(IAryCmpJT)
+    sense = true;
+    goto iarycmp;
+  CASE(IAryCmpJF)
+    sense = false;
+  iarycmp:
+    adrs = ary_element(pc);
+    if (adrs < 0) { SYNC_PC; ary_error(pc); }
+    i = Dmem.geti(adrs);
+    if (pc[3].n == Gvar || pc[3].n == Lvar) {
+      p = (pc[3].n == Gvar) ? &Gtable[pc[4].n] : &Ltable[pc[4].n];
+      if (p->dtTyp == NON_T) { SYNC_PC; err_exit("An uninitialized variable has been used: ", p->name); }
+      i2 = Dmem.geti(p->adrs + (pc[3].n == Gvar ? 0 : baseReg));
     }
+    else i2 = pc[4].i;
+    if (compare(pc[5].n, i, i2) == sense) pc = pc[6].jmp; else pc += 7;
+    NEXT;
+  CASE(RetIf)                                           //  Stack : value, condition
+    if (stk.pop()) { returnValue = stk.pop(); return; }
+    (void)stk.pop();
+    pc++; NEXT;
+  CASE(IRetIf)
+    if (stk.popi()) { returnValue = stk.pop(); return; }
+    (void)stk.pop();
+    pc++; NEXT;
+
+  CASE(Pop)     (void)stk.pop();           pc++; NEXT;
+  CASE(Dup)     stk.push(stk.peek(0));     pc++; NEXT;
+
+  CASE(Print)   out_dbl(stk.pop());        pc++; NEXT; //  Output numerical number
+  CASE(IPrint)  out_dbl((double)stk.popi()); pc++; NEXT;
+  CASE(String)  out_str(pc[1].s, strlen(pc[1].s)); pc += 2; NEXT;
+  CASE(Println) out_nl();                  pc++; NEXT;
+  CASE(Flush)   out_flush();               pc++; NEXT;
+
+#ifdef THREADED_CODE
+  L_Others:
+#else
+  default:
+    break;
   }
-  code = nextCode();                //  ) Skipping
-
-  //  Change of Arguments Loading Order
-  for (n = 0; n < argCt; n++) vc.push_back(stk.pop());  //  Correct to load arguments from the back
-  for (n = 0; n < argCt; n++) { stk.push(vc[n]); }
-
-  fncExec(fncNbr);                                      //  Function Executes
+#endif
+  SYNC_PC;
+  err_exit("Incorrect description");
 }
 
 
 /* Function Executes */
+/* The arguments go straight into the first slots of the new frame, where the parameters are,
+   so the callee has no code to store them.  The body runs in a nested run(), whose return is
+   well predicted by the processor.  A call in tail position (TailCall) reuses the frame instead.
+   A memoized function looks up its cache first, and keeps the value for the arguments of this call ;
+   the TailCalls it ends in share that value, so they go on without the cache.  The calls are
+   counted, and a function that has got hot goes up a tier (tier_up). */
 void fncExec(int fncNbr) {
+  SymTbl *p = &Gtable[fncNbr];
+  int save_baseReg = baseReg;       //  Store the current baseReg
+  int save_spReg   = spReg;         //  Store the current spReg
+  int save_stkBase = stkBaseReg;
+  int stkBase = stk.size() - p->args;   //  Actual arguments are pushed in order
+  Value key[MEMO_ARGS];
+  MemoEnt *m = NULL;
+  int n;
+
+  if (++p->calls + p->loops >= HOT_COUNT && p->tier == 0) tier_up(fncNbr);
+  if (!memoTbl[fncNbr].empty()) {
+    for (n = 0; n < p->args; n++) key[n] = stk.peekv(p->args - 1 - n);
+    m = memo_find(fncNbr, key);
+    if (m->used) {                  //  The value is known
+      stk.resize(stkBase);
+      stk.push(returnValue = m->val);
+      return;
+    }
+  }
 
-  //  Function Entrance Processing
-  int save_Pc         = Pc;         //  Store the current execution line
-  int save_baseReg    = baseReg;    //  Store the current baseReg
-  int save_spReg      = spReg;      //  Store the current spReg
-  char *save_code_ptr = code_ptr;   //  Store the current execution line analysis pointer
-  CodeSet save_code   = code;       //  Store the current code
-
-  Pc = Gtable[fncNbr].adrs;         //  Set the new Pc
   baseReg = spReg;                  //  Set the new baseReg
-  spReg += Gtable[fncNbr].frame;    //  Secure the frame
+  spReg += p->frame;                //  Secure the frame
   Dmem.auto_resize(spReg);          //  Secure the effective area of main memory
-  returnValue = 1.0;                //  Return ruled Value
-  code = firstCode(Pc);             //  Get initial code
-
-  nextCode(); code = nextCode();                //  Func  ( Skipping
-  if (code.kind != ')') {                       //  There are arguments
-    for (;; code=nextCode()) {
-      set_dtTyp(code, DBL_T);                   //  Determine the type when assigning
-      Dmem.set(get_memAdrs(code), stk.pop());   //  Storage actual arguments value
-      if (code.kind != ',') break;              //  End of arguments
-    }
+  for (n = 0; n < p->args; n++) {   //  Parameters are in the slots 0 .. args-1
+    Dmem.at(baseReg + n) = stk.peekv(p->args - 1 - n);
   }
-  code = nextCode();                            //  Skipping
+  stk.resize(stkBase);
+  stk.reserve(p->depth);            //  Secure the operand stack for the function
+  stkBaseReg = stkBase;
+  returnValue = 1.0;                //  Return ruled Value
+  loopCnt = &p->loops;              //  Jumps back of its loops are counted there
 
-  //  Function body processing
-  ++Pc; block(); return_Flg = false;            //  Function body processing
+  if (jitFnc[fncNbr] != NULL) jitFnc[fncNbr](&Dmem.at(baseReg));   //  Native code (--jit)
+  else run(fncEntry[fncNbr]);       //  Function body processing
 
-  //  Function exit processing
-  stk.push(returnValue);          //  Set return value
-  Pc       = save_Pc;             //  Restore the environment before the call
-  baseReg  = save_baseReg;
+  stk.resize(stkBase);              //  Function exit processing
+  stk.push(returnValue);            //  Set return value
+  baseReg  = save_baseReg;          //  Restore the environment before the call
   spReg    = save_spReg;
-  code_ptr = save_code_ptr;
-  code     = save_code;
+  stkBaseReg = save_stkBase;
+
+  if (m != NULL) {                  //  The entry may have been taken by a nested call, so it is written again
+    m->used = true; m->val = returnValue;
+    for (n = 0; n < p->args; n++) m->arg[n] = key[n];
+  }
 }
 
 
-/* Checking Built-in Function */
-void sysFncExec_syntax(TknKind kd) {
-  switch (kd) {
-  case Toint:
-      code = nextCode(); (void)get_expression('(', ')');
-      stk.push(1.0);
-      break;
-  case Input:
-      code = nextCode();
-      code = chk_nextCode(code, '('); code = chk_nextCode(code, ')');
-      stk.push(1.0);                                  //  Push Safety Value
-      break;
-  case Print: case Println:
-      do {
-        code = nextCode();
-        if (code.kind == String) code = nextCode();   //  Check string output
-        else (void)get_expression();                  //  Check number output
-      } while (code.kind == ',');                     //  If there is "," , parameter follows
-      chk_EofLine();
-      break;
+/* Call from the native code ; arg[-k] is the k-th argument, pushed as the interpreter would */
+double jit_fcall(int fncNbr, const double *arg) {
+  stk.reserve(Gtable[fncNbr].args + 1);
+  for (int n = 0; n < Gtable[fncNbr].args; n++) {
+    if (jitIntArg[fncNbr][n]) stk.pushi((long long)arg[-n]);
+    else                      stk.push(arg[-n]);
   }
+  fncExec(fncNbr);
+  return stk.pop();
 }
 
 
-/* Built-in Function Execute */
-void sysFncExec(TknKind kd) {
-  double d;
-  string s;
-
-  switch (kd) {
-  case Toint:
-      code = nextCode();
-      stk.push((int)get_expression('(', ')'));    //  Rounding down of fractions
-      break;
-  case Input:
-      nextCode(); nextCode(); code = nextCode();  //  Input  ( ) Skipping
-      getline(cin, s);                            //  Get 1 line
-      stk.push(atof(s.c_str()));                  //  Convert to numbers and store
-      break; 
-  case Print: case Println:
-      do {
-        code = nextCode();
-        if (code.kind == String) {
-          cout << code.text; code = nextCode();   //  Output strings
-        } else {
-          d = get_expression();                   //  Possibility of exit inside the function
-          if (!exit_Flg) cout << d;               //  Output numerical number
-        }
-      } while (code.kind == ',');                 //  If there is "," , parameter follows
-      if (kd == Println) cout << endl;            //  If it's println , break the line  
+/* Entry of the cache for the arguments : the one holding them, otherwise the one to replace (used is FALSE) */
+/* Each cache is direct mapped, so an entry is simply replaced by the next arguments that hash to it. */
+MemoEnt *memo_find(int fncNbr, const Value *key) {
+  unsigned long long h = fncNbr;
+  MemoEnt *m;
+  int n;
 
-      break;
+  for (n = 0; n < Gtable[fncNbr].args; n++) {          //  Doubles differ in the upper bits, so they are mixed down
+    h ^= (unsigned long long)key[n].i;
+    h ^= h >> 33; h *= 0xff51afd7ed558ccdULL; h ^= h >> 33; h *= 0xc4ceb9fe1a85ec53ULL; h ^= h >> 33;
   }
+  m = &memoTbl[fncNbr][h % MEMO_SIZ];
+  if (!m->used) return m;
+  for (n = 0; n < Gtable[fncNbr].args; n++) {
+    if (m->arg[n].i != key[n].i) { m->used = false; return m; }
+  }
+  return m;
 }
 
 
-/* Return the address of a simple variable or array element */
-int get_memAdrs(const CodeSet& cd) {
-  int adr=0, index, len;
+/* Memory address of the element a[index] for AryCmpJF and the like, -1 if it is not usable */
+/* pc[1] : Gvar or Lvar (double index on the stack), GvarI or LvarI (int64 index),
+           GvarU or LvarU (int64 index known to be in range),  pc[2] : the array */
+int ary_element(Icell *pc) {
+  bool glb = (pc[1].n == Gvar || pc[1].n == GvarI || pc[1].n == GvarU);
+  SymTbl *p = glb ? &Gtable[pc[2].n] : &Ltable[pc[2].n];
+  int adrs = p->adrs + (glb ? 0 : baseReg);
+  long long i;
   double d;
 
-  adr = get_topAdrs(cd);
-  len = tableP(cd)->aryLen;
-  code = nextCode();
-  if (len == 0) return adr;
-
-  d = get_expression('[', ']');
-  if ((int)d != d) err_exit("Specify the index as a number without fractions.");
-  if (syntaxChk_mode) return adr;
-
-  index = (int)d;
-  if (index < 0 || len <= index)
-    err_exit(index, " is outside of index range (index range:0-)", len-1, ")");
-  return adr + index; 
-}
-
-
-/* Returns the address of the beginning of the variable (or the beginning of the array in the case of an array). */
-int get_topAdrs(const CodeSet& cd) {
-  switch (cd.kind) {
-  case Gvar: return tableP(cd)->adrs;
-  case Lvar: return tableP(cd)->adrs + baseReg;
-  default: err_exit("Variable name is required: ", kind_to_s(cd));
+  if (pc[1].n == GvarU || pc[1].n == LvarU) {
+    if (p->dtTyp == NON_T) return -1;
+    i = stk.popi();
+    return adrs + (int)i;
   }
-  return 0;     //  Not in here
+  if (pc[1].n == GvarI || pc[1].n == LvarI) {
+    i = stk.peeki(0);
+    if (p->dtTyp == NON_T || i < 0 || p->aryLen <= i) return -1;
+  }
+  else {
+    d = stk.peek(0); i = (int)d;
+    if (p->dtTyp == NON_T || i != d || i < 0 || p->aryLen <= i) return -1;
+  }
+  (void)stk.popv();
+  return adrs + (int)i;
 }
 
 
-/* The end position corresponding to the if statement */
-int endline_of_If(int line) {
-  CodeSet cd;
-  char *save = code_ptr;
+/* Error of the array element for AryCmpJF and the like (the index is still on the stack) */
+void ary_error(Icell *pc) {
+  SymTbl *p = (pc[1].n == Gvar || pc[1].n == GvarI || pc[1].n == GvarU) ? &Gtable[pc[2].n] : &Ltable[pc[2].n];
 
-  cd = firstCode(line);
-  for (;;) {
-    line = cd.jmpAdrs;
-    cd = firstCode(line);
-    if (cd.kind == Elif || cd.kind == Else) continue;
-    if (cd.kind == End) break;
-  }
-  code_ptr = save;    //  Addition of index number
-  return line;
+  if (p->dtTyp == NON_T) err_exit("An uninitialized variable has been used: ", p->name);
+  if (pc[1].n == GvarI || pc[1].n == LvarI) chk_index((double)stk.peeki(0), p->aryLen);
+  chk_index(stk.peek(0), p->aryLen);
 }
 
 
-/* Checking code */
-void chk_EofLine() {
-  if (code.kind != EofLine) err_exit("Incorrect description: ", kind_to_s(code));
-}
-
+/* Checking the index of an array whose length is "len" */
+void chk_index(double d, int len) {
+  int index = (int)d;
 
-/* First code of the line */
-TknKind lookCode(int line) {
-  return (TknKind)(unsigned char)intercode[line][0];
+  if (index != d) err_exit("Specify the index as a number without fractions.");
+  if (index < 0 || len <= index)
+    err_exit(index, " is outside of index range (index range:0-)", len-1, ")");
 }
 
 
-/* Getting code with Checking */
-CodeSet chk_nextCode(const CodeSet& cd, int kind2) {
-  if (cd.kind != kind2) {
-    if (kind2   == EofLine) err_exit("Incorrect description: ", kind_to_s(cd));
-    if (cd.kind == EofLine) err_exit(kind_to_s(kind2), " is required");
-    err_exit(kind_to_s(kind2) + " is required before " + kind_to_s(cd) + "");
-  }
-  return nextCode();
-}
-
+/* Source line No. of the code at "adrs" */
+int adrs_to_lineNo(int adrs) {
+  vector< pair<int,int> >::iterator p;
 
-/* Getting first code */
-CodeSet firstCode(int line) {
-  code_ptr = intercode[line];
-  return nextCode();
+  p = upper_bound(srcLines.begin(), srcLines.end(), make_pair(adrs, INT_MAX));
+  if (p == srcLines.begin()) return 0;
+  return (p - 1)->second;
 }
 
 
 /* Getting code */
 CodeSet nextCode() {
   TknKind kd;
-  short int jmpAdrs, tblNbr;
+  int jmpAdrs, tblNbr;
 
-  if (*code_ptr == '\0') return CodeSet(EofLine);
   kd = (TknKind)*UCHAR_P(code_ptr++);
   switch (kd) {
-  case Func:
-  case While: case For: case If: case Elif: case Else:
-      jmpAdrs = *SHORT_P(code_ptr); code_ptr += SHORT_SIZ;
+  case Func: case Jump: case JumpF: case JumpT: case ForChk: case ForNext:
+      jmpAdrs = *OPR_P(code_ptr); code_ptr += OPR_SIZ;
       return CodeSet(kd, -1, jmpAdrs);                        //  Jumping adress
   case String:
-      tblNbr = *SHORT_P(code_ptr); code_ptr += SHORT_SIZ;
+      tblNbr = *OPR_P(code_ptr); code_ptr += OPR_SIZ;
       return CodeSet(kd, strLITERAL[tblNbr].c_str());         //  String Literal Position
   case IntNum: case DblNum:
-      tblNbr = *SHORT_P(code_ptr); code_ptr += SHORT_SIZ;     //  Number Literal Number
+      tblNbr = *OPR_P(code_ptr); code_ptr += OPR_SIZ;     //  Number Literal Number
       return CodeSet(kd, nbrLITERAL[tblNbr]); 
-  case Fcall: case Gvar: case Lvar:
-      tblNbr = *SHORT_P(code_ptr); code_ptr += SHORT_SIZ;
+  case Fcall: case Gvar: case Lvar: case Gset: case Lset: case Gadrs: case Ladrs:
+      tblNbr = *OPR_P(code_ptr); code_ptr += OPR_SIZ;
       return CodeSet(kd, tblNbr, -1);
+  case Gread: case Lread: case Gwrite: case Lwrite: {        //  Array, file name and format
+      tblNbr = *OPR_P(code_ptr); code_ptr += OPR_SIZ;
+      CodeSet cd(kd, tblNbr, -1);
+      cd.text = strLITERAL[*OPR_P(code_ptr)].c_str(); code_ptr += OPR_SIZ;
+      cd.fmt = *OPR_P(code_ptr); code_ptr += OPR_SIZ;
+      return cd;
+  }
   default:                                                    //  Code with no accompanying information
       return CodeSet(kd);
   }
 }
 
 
-/* Checking with Type */
-void chk_dtTyp(const CodeSet& cd) {
-  if (tableP(cd)->dtTyp == NON_T)
-    err_exit("An uninitialized variable has been used: ", kind_to_s(cd));
-}
-
 /* Setting Type */
-void set_dtTyp(const CodeSet& cd, char typ) {
-  int memAdrs = get_topAdrs(cd);
-  vector<SymTbl>::iterator p = tableP(cd);
-
+void set_dtTyp(SymTbl *p, int memAdrs, char typ) {
   if (p->dtTyp != NON_T) return;                              //  The type has already been determined
   p->dtTyp = typ;
   if (p->aryLen != 0) {                                       //  If it's an array, initialize the contents to zero
@@ -676,20 +1197,23 @@ void set_dtTyp(const CodeSet& cd, char typ) {
 
 
 /* Number Literal */
+/* The literals are hashed, by the bits of the number (so -0 is kept apart from 0) or by the string */
 int set_LITERAL(double d) {
-  for (int n = 0; n < (int)nbrLITERAL.size(); n++) {
-    if (nbrLITERAL[n] == d) return n;                         //  Return the same index num
-  }
+  unsigned long long bits;
+  unordered_map<unsigned long long,int>::iterator it;
+
+  memcpy(&bits, &d, sizeof bits);
+  if ((it = nbrIndex.find(bits)) != nbrIndex.end()) return it->second;   //  Return the same index num
   nbrLITERAL.push_back(d);                                    //  Store the Number Literal
-  return nbrLITERAL.size() - 1;                               //  Index position of stored Number Literal
+  return nbrIndex[bits] = nbrLITERAL.size() - 1;              //  Index position of stored Number Literal
 }
 
 
 /* String Literal */
 int set_LITERAL(const string& s) {  
-  for (int n = 0; n < (int)strLITERAL.size(); n++) {
-    if (strLITERAL[n] == s) return n;
-  }
+  unordered_map<string,int>::iterator it = strIndex.find(s);
+
+  if (it != strIndex.end()) return it->second;
   strLITERAL.push_back(s);          //  Store String Literal
-  return strLITERAL.size() - 1;     //  Index Position of Stored String Literal
+  return strIndex[s] = strLITERAL.size() - 1;   //  Index Position of Stored String Literal
 }
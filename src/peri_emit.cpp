@@ -0,0 +1,361 @@
+/********************************************************************************************************
+ *
+ *      PROJECT NAME    :   ASMI Demo Contest 2022
+ *
+ *      FILE NAME       :   peri_emit.cpp
+ *
+ *      OUTLINE         :   Translation of the internal code into a C++ source (--emit-cpp)
+ *
+ *      REQUIRED FILES  :   peri.h, peri_prot.h
+ *
+ *      EDITOR : Taichi KATO,   Advanced Sensing & Machine Intelligence Group,  Chukyo Univ.
+ *
+ *      LAST UPDATED : Apl. 17, 2022
+ *
+ *      Copyright © 2022 Taichi KATO. All rights reserved.
+ *
+*********************************************************************************************************/
+/* Header File */
+#include "peri.h"
+#include "peri_prot.h"
+
+
+bool emitCpp_F;                         //  If TRUE, write the program in C++ instead of running it (--emit-cpp)
+extern vector<char> intercode;
+extern vector<SymTbl> Gtable;
+extern vector<SymTbl> Ltable;
+extern vector<char> initVar;
+extern vector<char> safeIdx;
+extern char *code_ptr;
+extern int startPc;
+extern int Pc;
+extern Mymemory Dmem;
+
+
+/* Translation into C++ */
+/* Every function of the program becomes a C++ function, and the codes become statements on
+   variables s0, s1, ... standing for the operand stack (its depth at each code is fixed).
+   The memory, the frames and the checks are the same as in the interpreter, so the program
+   compiled by g++ prints the same results and the same errors. */
+void emit_cpp(const char *fname) {
+  ostream& out = cout;
+  int n;
+
+  infer_types();                                        //  Indices proved to be in range
+  find_assigned();                                      //  Variables needing no check
+  for (n = 0; n < (int)Gtable.size(); n++) {            //  Parameters are assigned by the call
+    if (Gtable[n].nmKind != fncId) continue;
+    for (int k = 0; k < Gtable[n].args; k++) Ltable[param_sym(n, k)].dtTyp = DBL_T;
+  }
+
+  out << "/* " << fname << " translated by peri --emit-cpp */\n";
+  out << "#include <iostream>\n#include <fstream>\n#include <string>\n#include <vector>\n#include <cstdlib>\n#include <cstring>\n#include <cmath>\n#include <climits>\n\n";
+  out << "using namespace std;\n\n";
+  out << "static vector<double> M(" << Dmem.size() + 1000 << ");   //  Main memory\n";
+  out << "static int baseReg = 0, spReg = " << Dmem.size() << ";\n";
+  out << "static double returnValue;\n";
+  out << "static bool exit_Flg;\n";
+  out << "static char gTyp[" << Gtable.size() + 1 << "] = {";   //  The variable has been assigned
+  for (n = 0; n < (int)Gtable.size(); n++) out << (Gtable[n].dtTyp != NON_T ? "1," : "0,");
+  out << "0};\n";
+  out << "static char lTyp[" << Ltable.size() + 1 << "] = {";
+  for (n = 0; n < (int)Ltable.size(); n++) out << (Ltable[n].dtTyp != NON_T ? "1," : "0,");
+  out << "0};\n\n";
+
+  out << "static inline void err(int line, const string& s) {\n"
+         "  cerr << \"line:\" << line << \" ERROR \";\n"
+         "  cout << s << endl;\n"
+         "  exit(1);\n"
+         "}\n"
+         "static inline void uninit(int line, const char *name) {\n"
+         "  err(line, string(\"An uninitialized variable has been used: \") + name);\n"
+         "}\n"
+         "static inline int toi(double d) {       //  (int)d as the processor does it, also out of range\n"
+         "  return (d > -2147483649.0 && d < 2147483648.0) ? (int)d : INT_MIN;\n"
+         "}\n"
+         "static inline int chk_index(int line, double d, int len) {\n"
+         "  int i = toi(d);\n"
+         "  if (i != d) err(line, \"Specify the index as a number without fractions.\");\n"
+         "  if (i < 0 || len <= i) {\n"
+         "    cerr << \"line:\" << line << \" ERROR \";\n"
+         "    cout << (double)i << \" is outside of index range (index range:0-)\" << (double)(len - 1) << \")\" << endl;\n"
+         "    exit(1);\n"
+         "  }\n"
+         "  return i;\n"
+         "}\n"
+         "static inline void set_typ(char& t, int adrs, int len) {\n"
+         "  if (t) return;\n"
+         "  t = 1;\n"
+         "  for (int n = 0; n < len; n++) M[adrs + n] = 0;\n"
+         "}\n"
+         "static inline double input() {\n"
+         "  string s;\n"
+         "  getline(cin, s);\n"
+         "  return atof(s.c_str());\n"
+         "}\n"
+         "static double readarray(int line, int adrs, int len, const char *fname) {\n"
+         "  ifstream fin;\n"
+         "  istream *in = &cin;\n"
+         "  string w;\n"
+         "  char *e;\n"
+         "  int n = 0;\n"
+         "  if (*fname) {\n"
+         "    fin.open(fname);\n"
+         "    if (!fin) err(line, string(\"The file cannot be opened : \") + fname);\n"
+         "    in = &fin;\n"
+         "  }\n"
+         "  while (n < len && *in >> w) {\n"
+         "    double d = strtod(w.c_str(), &e);\n"
+         "    if (*e) break;\n"
+         "    M[adrs + n++] = d;\n"
+         "  }\n"
+         "  return n;\n"
+         "}\n"
+         "static const int fmtWidth[] = { 0, 8, 4, 4, 8 };    //  double, float, int32, int64\n"
+         "static double loadarray(int line, int adrs, int len, const char *fname, int fmt) {\n"
+         "  ifstream fin(fname, ios::in | ios::binary);\n"
+         "  double d; float f; int i; long long l;\n"
+         "  char b[8];\n"
+         "  int n;\n"
+         "  if (!fin) err(line, string(\"The file cannot be opened : \") + fname);\n"
+         "  for (n = 0; n < len && fin.read(b, fmtWidth[fmt]); n++) {\n"
+         "    if (fmt == 1) { memcpy(&d, b, 8); M[adrs + n] = d; }\n"
+         "    if (fmt == 2) { memcpy(&f, b, 4); M[adrs + n] = f; }\n"
+         "    if (fmt == 3) { memcpy(&i, b, 4); M[adrs + n] = i; }\n"
+         "    if (fmt == 4) { memcpy(&l, b, 8); M[adrs + n] = (double)l; }\n"
+         "  }\n"
+         "  return n;\n"
+         "}\n"
+         "static double storearray(int line, int adrs, int len, const char *fname, int fmt) {\n"
+         "  ofstream fout(fname, ios::out | ios::binary | ios::trunc);\n"
+         "  double d; float f; int i; long long l;\n"
+         "  char b[8];\n"
+         "  if (!fout) err(line, string(\"The file cannot be opened : \") + fname);\n"
+         "  for (int n = 0; n < len; n++) {\n"
+         "    d = M[adrs + n];\n"
+         "    if (fmt == 1) memcpy(b, &d, 8);\n"
+         "    if (fmt == 2) { f = (float)d; memcpy(b, &f, 4); }\n"
+         "    if (fmt == 3) { i = toi(d); memcpy(b, &i, 4); }\n"
+         "    if (fmt == 4) { l = (d >= -9223372036854775808.0 && d < 9223372036854775808.0) ? (long long)d : LLONG_MIN; memcpy(b, &l, 8); }\n"
+         "    fout.write(b, fmtWidth[fmt]);\n"
+         "  }\n"
+         "  if (!fout.flush()) err(line, string(\"The file cannot be written : \") + fname);\n"
+         "  return len;\n"
+         "}\n\n";
+
+  for (n = 0; n < (int)Gtable.size(); n++) {           //  Declarations
+    if (Gtable[n].nmKind == fncId) out << "static double " << emit_fncName(n) << "(" << emit_params(n) << ");\n";
+  }
+  out << "\n";
+  for (n = 0; n < (int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind == fncId) emit_function(out, n);
+  }
+
+  out << "int main() {\n";
+  emit_body(out, startPc, intercode.size(), startPc, 0, -1);
+  out << "  return 0;\n}\n";
+}
+
+
+/* C++ function of the function "fncNbr" */
+void emit_function(ostream& out, int fncNbr) {
+  SymTbl& f = Gtable[fncNbr];
+  int k;
+
+  out << "static double " << emit_fncName(fncNbr) << "(" << emit_params(fncNbr) << ") {   //  " << f.name << "\n";
+  out << "  int save_baseReg = baseReg, save_spReg = spReg;\n";
+  out << "  baseReg = spReg; spReg += " << f.frame << ";\n";
+  out << "  if (spReg >= (int)M.size()) M.resize((spReg / 256 + 1) * 256);\n";
+  for (k = 0; k < f.args; k++) out << "  M[baseReg + " << Ltable[param_sym(fncNbr, k)].adrs << "] = a" << k << ";\n";
+  out << "  returnValue = 1.0;\n";
+  emit_body(out, f.adrs, fnc_end(fncNbr), fnc_body(fncNbr), f.args, fncNbr);
+  out << " ret:\n";
+  out << "  baseReg = save_baseReg; spReg = save_spReg;\n";
+  out << "  return returnValue;\n}\n\n";
+}
+
+
+/* Statements of the codes from "top" up to "end" ; the flow starts at "entry" with "args" values on the stack */
+/* fncNbr : the function, -1 for the main program (outside functions) */
+void emit_body(ostream& out, int top, int end, int entry, int args, int fncNbr) {
+  vector<int> depth(intercode.size(), -1);
+  vector<char> target(intercode.size() + 1, 0);
+  int save_Pc = Pc, maxDepth, adrs, k;
+  CodeSet cd;
+
+  maxDepth = chk_stkDepth(depth, top, args);
+  Pc = save_Pc;
+  for (code_ptr = &intercode[top]; code_ptr < &intercode[end]; ) {
+    adrs = code_ptr - &intercode[0];
+    cd = nextCode();
+    if ((is_jump(cd.kind) || cd.kind == Func) && depth[adrs] != -1) target[cd.jmpAdrs] = 1;
+  }
+  if (maxDepth > 0) {
+    out << "  double s0";
+    for (k = 1; k < maxDepth; k++) out << ", s" << k;
+    out << ";\n";
+  }
+
+  for (code_ptr = &intercode[entry]; code_ptr < &intercode[end]; ) {
+    adrs = code_ptr - &intercode[0];
+    cd = nextCode();
+    if (target[adrs]) out << " L" << adrs << ":\n";
+    if (depth[adrs] == -1) continue;                    //  Never reached
+    emit_code(out, adrs, cd, depth[adrs], fncNbr);
+  }
+  if (target[end]) out << " L" << end << ":;\n";
+}
+
+
+/* Statement of one code ; "dp" is the depth of the operand stack before it */
+void emit_code(ostream& out, int adrs, const CodeSet& cd, int dp, int fncNbr) {
+  string a = "s" + to_string(dp - 2), b = "s" + to_string(dp - 1), t = "s" + to_string(dp);
+  string leave = (fncNbr == -1) ? "return 0;" : "goto ret;";
+  int line = adrs_to_lineNo(adrs), k;
+  vector<SymTbl>::iterator p;
+  string base, typ;
+
+  switch (cd.kind) {
+  case Gvar: case Lvar: case Gadrs: case Ladrs: case Gset: case Lset: case Gread: case Lread: case Gwrite: case Lwrite:
+      p = tableP(cd);
+      if (cd.kind == Gvar || cd.kind == Gadrs || cd.kind == Gset || cd.kind == Gread || cd.kind == Gwrite) {
+        base = to_string(p->adrs); typ = "gTyp[" + to_string(cd.symNbr) + "]";
+      } else {
+        base = "baseReg + " + to_string(p->adrs); typ = "lTyp[" + to_string(cd.symNbr) + "]";
+      }
+      break;
+  default:
+      break;
+  }
+
+  out << "  ";
+  switch (cd.kind) {
+  case IntNum: case DblNum: out << t << " = " << emit_dbl(cd.dblVal) << ";"; break;
+  case String:  out << "cout << " << emit_str(cd.text) << ";";              break;
+  case Print:   out << "cout << " << b << ";";                              break;
+  case Println: out << "cout << endl;";                                     break;
+  case Flush:   out << "cout << flush;";                                    break;
+  case Input:   out << t << " = input();";                                  break;
+  case Gread: case Lread:
+      out << "set_typ(" << typ << ", " << base << ", " << p->aryLen << "); ";
+      if (cd.fmt == FMT_TEXT) out << t << " = readarray(" << line << ", " << base << ", " << p->aryLen << ", " << emit_str(cd.text) << ");";
+      else out << t << " = loadarray(" << line << ", " << base << ", " << p->aryLen << ", " << emit_str(cd.text) << ", " << cd.fmt << ");";
+      break;
+  case Gwrite: case Lwrite:
+      out << "if (!" << typ << ") uninit(" << line << ", \"" << p->name << "\"); ";
+      out << t << " = storearray(" << line << ", " << base << ", " << p->aryLen << ", " << emit_str(cd.text) << ", " << cd.fmt << ");";
+      break;
+  case Pop:     out << ";";                                                 break;
+  case Dup:     out << t << " = " << b << ";";                              break;
+
+  case Gvar: case Lvar:
+      if (!initVar[adrs]) out << "if (!" << typ << ") uninit(" << line << ", \"" << p->name << "\"); ";
+      if (p->aryLen == 0) out << t << " = M[" << base << "];";
+      else if (safeIdx[adrs]) out << b << " = M[" << base << " + (int)" << b << "];";
+      else out << b << " = M[" << base << " + chk_index(" << line << ", " << b << ", " << p->aryLen << ")];";
+      break;
+  case Gadrs: case Ladrs:                               //  Addresses are held as double
+      if (p->aryLen == 0) out << t << " = " << base << ";";
+      else if (safeIdx[adrs]) out << b << " = " << base << " + (int)" << b << ";";
+      else out << b << " = " << base << " + chk_index(" << line << ", " << b << ", " << p->aryLen << ");";
+      break;
+  case Gset: case Lset:
+      if (p->aryLen == 0) {
+        if (!initVar[adrs]) out << typ << " = 1; ";
+        out << "M[" << base << "] = " << b << ";";
+      } else {
+        out << "set_typ(" << typ << ", " << base << ", " << p->aryLen << "); ";
+        out << "M[(int)" << a << "] = " << b << ";";
+      }
+      break;
+
+  case Plus: case Minus: case Multi: case Less: case LessEq: case Great: case GreatEq:
+  case Equal: case NotEq: case And: case Or:
+      out << a << " = " << a << " " << emit_op(cd.kind) << " " << b << ";";
+      break;
+  case Divi: case Mod: case IntDivi:
+      out << "if (" << b << " == 0) err(" << line << ", \"Division by Zero\"); ";
+      if (cd.kind == Divi) out << a << " = " << a << " / " << b << ";";
+      else out << a << " = toi(" << a << (cd.kind == Mod ? ") % " : ") / ") << "toi(" << b << ");";
+      break;
+  case Not:     out << b << " = !" << b << ";";                             break;
+  case Uminus:  out << b << " = -" << b << ";";                             break;
+  case Toint:   out << b << " = toi(" << b << ");";                         break;
+
+  case Jump:    out << "goto L" << cd.jmpAdrs << ";";                       break;
+  case Func:    out << "goto L" << cd.jmpAdrs << ";";                       break;
+  case JumpF:   out << "if (!" << b << ") goto L" << cd.jmpAdrs << ";";      break;
+  case JumpT:   out << "if (" << b << ") goto L" << cd.jmpAdrs << ";";       break;
+  case ForChk:                                          //  Stack : address, last value, step
+      out << "if (" << b << " >= 0 ? M[(int)s" << dp - 3 << "] > " << a << " : M[(int)s" << dp - 3 << "] < " << a << ") goto L" << cd.jmpAdrs << ";";
+      break;
+  case ForNext:
+      out << "M[(int)s" << dp - 3 << "] += " << b << "; goto L" << cd.jmpAdrs << ";";
+      break;
+
+  case Fcall:
+      k = dp - Gtable[cd.symNbr].args;
+      out << "s" << k << " = " << emit_fncName(cd.symNbr) << "(";
+      for (int n = 0; n < Gtable[cd.symNbr].args; n++) out << (n ? ", s" : "s") << k + n;
+      out << "); if (exit_Flg) " << leave;
+      break;
+  case Return:  out << "returnValue = " << b << "; " << leave;              break;
+  case RetSet:  out << "returnValue = " << b << ";";                        break;
+  case RetVal:  out << t << " = returnValue;";                              break;
+  case Exit:    out << "exit_Flg = true; " << leave;                        break;
+  case EofProg: out << leave;                                               break;
+  default:      break;
+  }
+  out << "\n";
+}
+
+
+/* Name of the C++ function */
+string emit_fncName(int fncNbr) {
+  return "f" + to_string(fncNbr) + "_" + Gtable[fncNbr].name;
+}
+
+
+/* Parameters of the C++ function */
+string emit_params(int fncNbr) {
+  string s;
+  for (int k = 0; k < Gtable[fncNbr].args; k++) s += (k ? ", double a" : "double a") + to_string(k);
+  return s;
+}
+
+
+/* Operator of the code */
+string emit_op(TknKind kd) {
+  switch (kd) {
+  case Plus:    return "+";   case Minus:  return "-";   case Multi:   return "*";
+  case Less:    return "<";   case LessEq: return "<=";  case Great:   return ">";
+  case GreatEq: return ">=";  case Equal:  return "==";  case NotEq:   return "!=";
+  case And:     return "&&";  default:     return "||";
+  }
+}
+
+
+/* Literal of the double value (the same value when read back) */
+string emit_dbl(double d) {
+  char buf[40];
+
+  if (std::isnan(d)) return "NAN";
+  if (std::isinf(d)) return d > 0 ? "HUGE_VAL" : "-HUGE_VAL";
+  sprintf(buf, "%.17g", d);
+  if (strpbrk(buf, ".e") == NULL) strcat(buf, ".0");
+  return buf;
+}
+
+
+/* Literal of the string */
+string emit_str(const char *s) {
+  string r = "\"";
+  char buf[8];
+
+  for (; *s; s++) {
+    if (*s == '"' || *s == '\\') { r += '\\'; r += *s; }
+    else if ((unsigned char)*s < ' ') { sprintf(buf, "\\%03o", (unsigned char)*s); r += buf; }
+    else r += *s;
+  }
+  return r + "\"";
+}
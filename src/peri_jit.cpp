@@ -0,0 +1,412 @@
+/********************************************************************************************************
+ *
+ *      PROJECT NAME    :   ASMI Demo Contest 2022
+ *
+ *      FILE NAME       :   peri_jit.cpp
+ *
+ *      OUTLINE         :   Compilation of functions into native code (x86-64 Linux only)
+ *
+ *      REQUIRED FILES  :   peri.h, peri_prot.h
+ *
+ *      EDITOR : Taichi KATO,   Advanced Sensing & Machine Intelligence Group,  Chukyo Univ.
+ *
+ *      LAST UPDATED : Apl. 17, 2022
+ *
+ *      Copyright © 2022 Taichi KATO. All rights reserved.
+ *
+*********************************************************************************************************/
+/* Header File */
+#include "peri.h"
+#include "peri_prot.h"
+
+#if defined(__x86_64__) && defined(__linux__)
+#define JIT_X64
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+
+bool jit_F;                             //  If TRUE, compile the functions into native code (--jit)
+vector<JitFnc> jitFnc;                  //  Native code of each function (by the symbol table No.)  NULL : interpreted
+vector< vector<char> > jitIntArg;       //  The parameter of the function is held as int64
+vector<unsigned char> jitBuf;           //  Native code being made
+vector< pair<int,int> > jitFix;         //  rel32 to be fixed (position in jitBuf, address of the internal code)
+int jitFrame;                           //  Slots of the locals in the native frame
+bool tierRpt_F;                         //  If TRUE, report the tiers (--tier-report)
+long long topLoops;                     //  Jumps back of the loops outside functions
+long long *loopCnt;                     //  Counter of the jumps back for the next run()
+#ifdef JIT_X64
+ofstream perfMap;                       //  /tmp/perf-<pid>.map
+#endif
+extern vector<char> intercode;
+extern vector<SymTbl> Gtable;
+extern vector<SymTbl> Ltable;
+extern vector< vector<AbsVal> > entryStk;
+extern char *code_ptr;
+extern double returnValue;
+extern bool exit_Flg;
+extern int Pc;
+
+
+/* Tiers */
+/* Every function starts in the threaded code (tier 0).  fncExec() counts its calls, and the jumps
+   back of its loops (LoopJump, ForNext, ...) are counted too ; when the two make HOT_COUNT, the
+   function is compiled into native code (tier 1) with --jit, and its next calls run the native code.
+   A call already running goes on in the threaded code, so a hot loop outside functions stays there.
+   --tier-report shows the counters and the tier each function has ended in. */
+void jit_compile() {
+  jitFnc.assign(Gtable.size(), (JitFnc)NULL);
+  jitIntArg.assign(Gtable.size(), vector<char>());
+  topLoops = 0; loopCnt = &topLoops;
+  for (int n = 0; n < (int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind != fncId) continue;
+    for (int k = 0; k < Gtable[n].args; k++) jitIntArg[n].push_back(is_intVar(Lvar, param_sym(n, k)));
+  }
+}
+
+
+/* The function has got hot : native code if possible, otherwise it stays in the threaded code for good */
+void tier_up(int fncNbr) {
+  Gtable[fncNbr].tier = -1;
+  if (!jit_F) return;
+#ifdef JIT_X64
+  char name[64];
+  unsigned char *p;
+  size_t siz, page = sysconf(_SC_PAGESIZE);
+
+  if (!jit_function(fncNbr)) return;
+  siz = (jitBuf.size() + page - 1) / page * page;
+  p = (unsigned char *)mmap(NULL, siz, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (p == MAP_FAILED) return;
+  memcpy(p, &jitBuf[0], jitBuf.size());
+  if (mprotect(p, siz, PROT_READ | PROT_EXEC) != 0) { munmap(p, siz); return; }
+  jitFnc[fncNbr] = (JitFnc)p;
+  Gtable[fncNbr].tier = 1;
+  if (!perfMap.is_open()) {                     //  Names of the native codes for perf
+    sprintf(name, "/tmp/perf-%d.map", (int)getpid());
+    perfMap.open(name);
+  }
+  if (perfMap) perfMap << hex << (unsigned long)p << " " << jitBuf.size() << dec << " peri:" << Gtable[fncNbr].name << endl;
+#endif
+}
+
+
+/* Report of the tiers */
+void tier_report() {
+  cerr << "Tier report" << endl;
+  for (int n = 0; n < (int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind != fncId) continue;
+    cerr << "  " << Gtable[n].name << " : tier " << (Gtable[n].tier == 1 ? "1 (native)" : "0 (threaded)")
+         << "  calls " << Gtable[n].calls << "  loops " << Gtable[n].loops << endl;
+  }
+  cerr << "  (outside functions)  loops " << topLoops << endl;
+}
+
+
+/* Native Code */
+/* Every value is a double in the native code.  The locals and the operand stack (whose depth at
+   each code is fixed) get slots in the native stack frame, and each code works on them through
+   xmm0 and xmm1.  Calls go back to fncExec(), so a compiled function may call any function ;
+   a call of itself in tail position is a jump back to the body, which reuses the frame as TailCall
+   does.  A tail call of another function is left to the interpreter, so the function is not
+   compiled.  The functions not compiled are interpreted as before. */
+/* Make the native code of the function in jitBuf, FALSE if it has a code not supported */
+bool jit_function(int fncNbr) {
+  int top = Gtable[fncNbr].adrs, body = fnc_body(fncNbr), end = fnc_end(fncNbr);
+  vector<int> depth(intercode.size(), -1);
+  vector<int> natAdrs(intercode.size() + 1, -1);       //  Position of the native code of each code
+  vector<int> codeNo(intercode.size() + 1, -1);        //  Index in cds of each code address
+  vector<char> selfTail(intercode.size() + 1, 0);      //  Call of itself in tail position
+  vector<CodeSet> cds;
+  vector<int> cdAdrs;
+  int save_Pc = Pc, adrs, maxDepth, n, epilog;
+  CodeSet cd;
+
+  if (!locals_assigned(fncNbr)) return false;           //  Reading a local needs no check
+  for (code_ptr = &intercode[body]; code_ptr < &intercode[end]; ) {
+    adrs = code_ptr - &intercode[0];
+    cd = nextCode();
+    if (!jit_supported(adrs, cd)) return false;
+    codeNo[adrs] = cds.size(); cds.push_back(cd); cdAdrs.push_back(adrs);
+  }
+  codeNo[end] = cds.size();                             //  Out of the function : not a tail call
+  for (n = 0; n < (int)cds.size(); n++) {
+    if (cds[n].kind != Fcall || !is_tailCall(cds, codeNo, n)) continue;
+    if (cds[n].symNbr != fncNbr) return false;          //  The frame is reused by TailCall only
+    selfTail[cdAdrs[n]] = 1;
+  }
+  maxDepth = chk_stkDepth(depth, top, Gtable[fncNbr].args);
+  Pc = save_Pc;
+
+  jitBuf.clear(); jitFix.clear();
+  jitFrame = Gtable[fncNbr].frame;
+  jit_bytes("\x55\x48\x89\xE5", 4);                     //  push rbp ; mov rbp, rsp
+  jit_bytes("\x48\x81\xEC", 3);                         //  sub rsp, frame
+  jit_int32(((jitFrame + maxDepth + 1) * 8 + 15) / 16 * 16);
+  for (n = 0; n < Gtable[fncNbr].args; n++) {           //  Parameters from the frame of Dmem (rdi)
+    jit_bytes("\x48\x8B\x87", 3); jit_int32(Ltable[param_sym(fncNbr, n)].adrs * 8);   //  mov rax, [rdi+d]
+    if (jitIntArg[fncNbr][n]) {
+      jit_bytes("\xF2\x48\x0F\x2A\xC0", 5);             //  cvtsi2sd xmm0, rax
+      jit_bytes("\x66\x48\x0F\x7E\xC0", 5);             //  movq rax, xmm0
+    }
+    jit_store(jit_local(Ltable[param_sym(fncNbr, n)].adrs));
+  }
+
+  for (code_ptr = &intercode[body]; code_ptr < &intercode[end]; ) {
+    adrs = code_ptr - &intercode[0];
+    cd = nextCode();
+    natAdrs[adrs] = jitBuf.size();
+    if (depth[adrs] == -1) continue;
+    if (selfTail[adrs]) jit_selfTail(fncNbr, depth[adrs]);
+    else jit_code(adrs, cd, depth[adrs]);
+  }
+  epilog = natAdrs[end] = jitBuf.size();
+  jit_bytes("\xC9\xC3", 2);                             //  leave ; ret
+
+  for (n = 0; n < (int)jitFix.size(); n++) {
+    adrs = (jitFix[n].second == -1) ? epilog : natAdrs[jitFix[n].second];
+    *(int *)&jitBuf[jitFix[n].first] = adrs - (jitFix[n].first + 4);
+  }
+  return true;
+}
+
+
+/* TRUE if the code at "adrs" can be compiled */
+bool jit_supported(int adrs, const CodeSet& cd) {
+  const vector<AbsVal>& e = entryStk[cd.kind == ForNext ? (int)cd.jmpAdrs : adrs];
+
+  switch (cd.kind) {
+  case Lvar: case Lset: case Ladrs:
+      return Ltable[cd.symNbr].aryLen == 0;
+  case ForChk: case ForNext:                            //  The control variable has to be a local
+      return e.size() >= 3 && e[e.size()-3].sym != -1 && e[e.size()-3].symKind == Lvar
+             && Ltable[e[e.size()-3].sym].aryLen == 0;
+  case IntNum: case DblNum: case Plus: case Minus: case Multi: case Divi: case Mod: case IntDivi:
+  case Less: case LessEq: case Great: case GreatEq: case Equal: case NotEq: case And: case Or:
+  case Not: case Uminus: case Toint: case Jump: case JumpF: case JumpT:
+  case Pop: case Dup: case Fcall: case Return: case RetSet: case RetVal:
+      return true;
+  default:                                              //  Global variables, input and output, exit
+      return false;
+  }
+}
+
+
+/* Native code of one code ; "dp" is the depth of the operand stack before it */
+void jit_code(int adrs, const CodeSet& cd, int dp) {
+  int a = jit_slot(dp - 2), b = jit_slot(dp - 1), t = jit_slot(dp), var;
+  double d;
+  long long bits;
+
+  switch (cd.kind) {
+  case IntNum: case DblNum:
+      d = cd.dblVal; memcpy(&bits, &d, sizeof(bits));
+      jit_bytes("\x48\xB8", 2); jit_int64(bits);       //  mov rax, imm64
+      jit_store(t);
+      break;
+  case Lvar:  jit_load(jit_local(Ltable[cd.symNbr].adrs)); jit_store(t); break;
+  case Lset:  jit_load(b); jit_store(jit_local(Ltable[cd.symNbr].adrs)); break;
+  case Dup:   jit_load(b); jit_store(t);                                  break;
+  case Ladrs: case Pop:                                 //  The address of a control variable is not used
+      break;
+
+  case Plus: case Minus: case Multi:
+      jit_sse("\xF2\x0F\x10", 0, a);                    //  movsd xmm0, [a]
+      if (cd.kind == Plus)  jit_sse("\xF2\x0F\x58", 0, b);
+      if (cd.kind == Minus) jit_sse("\xF2\x0F\x5C", 0, b);
+      if (cd.kind == Multi) jit_sse("\xF2\x0F\x59", 0, b);
+      jit_sse("\xF2\x0F\x11", 0, a);                    //  movsd [a], xmm0
+      break;
+  case Divi: case Mod: case IntDivi:
+      jit_sse("\xF2\x0F\x10", 1, b);                    //  movsd xmm1, [b]
+      jit_bytes("\x66\x0F\x57\xD2", 4);                 //  xorpd xmm2, xmm2
+      jit_bytes("\x66\x0F\x2E\xCA", 4);                 //  ucomisd xmm1, xmm2
+      jit_bytes("\x75\x13\x7A\x11", 4);                 //  jne ; jp  over the next 17 bytes (not zero)
+      jit_bytes("\xBF", 1); jit_int32(adrs);            //  mov edi, adrs
+      jit_call((void *)jit_divError);                   //  (12 bytes)
+      jit_sse("\xF2\x0F\x10", 0, a);                    //  movsd xmm0, [a]
+      if (cd.kind == Divi) jit_bytes("\xF2\x0F\x5E\xC1", 4);   //  divsd xmm0, xmm1
+      else {
+        jit_bytes("\xF2\x0F\x2C\xC0", 4);               //  cvttsd2si eax, xmm0
+        jit_bytes("\xF2\x0F\x2C\xC9", 4);               //  cvttsd2si ecx, xmm1
+        jit_bytes("\x99\xF7\xF9", 3);                   //  cdq ; idiv ecx
+        if (cd.kind == Mod) jit_bytes("\x89\xD0", 2);   //  mov eax, edx
+        jit_bytes("\xF2\x0F\x2A\xC0", 4);               //  cvtsi2sd xmm0, eax
+      }
+      jit_sse("\xF2\x0F\x11", 0, a);
+      break;
+  case Less: case LessEq:                               //  b > a , b >= a
+      jit_sse("\xF2\x0F\x10", 0, b);
+      jit_sse("\x66\x0F\x2E", 0, a);                    //  ucomisd xmm0, [a]
+      jit_bytes(cd.kind == Less ? "\x0F\x97\xC0" : "\x0F\x93\xC0", 3);   //  seta al / setae al
+      jit_bool(a);
+      break;
+  case Great: case GreatEq: case Equal: case NotEq:
+      jit_sse("\xF2\x0F\x10", 0, a);
+      jit_sse("\x66\x0F\x2E", 0, b);                    //  ucomisd xmm0, [b]
+      if (cd.kind == Great)   jit_bytes("\x0F\x97\xC0", 3);
+      if (cd.kind == GreatEq) jit_bytes("\x0F\x93\xC0", 3);
+      if (cd.kind == Equal)   jit_bytes("\x0F\x94\xC0\x0F\x9B\xC1\x20\xC8", 8);   //  sete al ; setnp cl ; and al, cl
+      if (cd.kind == NotEq)   jit_bytes("\x0F\x95\xC0\x0F\x9A\xC1\x08\xC8", 8);   //  setne al ; setp cl ; or al, cl
+      jit_bool(a);
+      break;
+  case And: case Or:
+      jit_truth(a);
+      jit_bytes("\x88\xC2", 2);                         //  mov dl, al
+      jit_truth(b);
+      jit_bytes(cd.kind == And ? "\x20\xD0" : "\x08\xD0", 2);   //  and al, dl / or al, dl
+      jit_bool(a);
+      break;
+  case Not:
+      jit_truth(b);
+      jit_bytes("\x34\x01", 2);                         //  xor al, 1
+      jit_bool(b);
+      break;
+  case Uminus:
+      jit_load(b);
+      jit_bytes("\x48\x0F\xBA\xF8\x3F", 5);             //  btc rax, 63
+      jit_store(b);
+      break;
+  case Toint:
+      jit_sse("\xF2\x0F\x10", 0, b);
+      jit_bytes("\xF2\x0F\x2C\xC0", 4);                 //  cvttsd2si eax, xmm0
+      jit_bytes("\xF2\x0F\x2A\xC0", 4);                 //  cvtsi2sd xmm0, eax
+      jit_sse("\xF2\x0F\x11", 0, b);
+      break;
+
+  case Jump:
+      jit_bytes("\xE9", 1); jit_rel32(cd.jmpAdrs);
+      break;
+  case JumpF: case JumpT:
+      jit_truth(b);
+      jit_bytes("\x84\xC0", 2);                         //  test al, al
+      jit_bytes(cd.kind == JumpF ? "\x0F\x84" : "\x0F\x85", 2); jit_rel32(cd.jmpAdrs);   //  je / jne
+      break;
+  case ForChk:                                          //  Stack : address, last value, step
+      var = jit_local(Ltable[entryStk[adrs][dp-3].sym].adrs);
+      jit_sse("\xF2\x0F\x10", 1, b);                    //  movsd xmm1, [step]
+      jit_bytes("\x66\x0F\x57\xD2", 4);                 //  xorpd xmm2, xmm2
+      jit_bytes("\x66\x0F\x2E\xCA", 4);                 //  ucomisd xmm1, xmm2
+      jit_bytes("\x72\x18", 2);                         //  jb down  (step < 0, or NaN)
+      jit_sse("\xF2\x0F\x10", 0, var);                  //  movsd xmm0, [var]     (8 bytes)
+      jit_sse("\x66\x0F\x2E", 0, a);                    //  ucomisd xmm0, [last]  (8 bytes)
+      jit_bytes("\x0F\x87", 2); jit_rel32(cd.jmpAdrs);   //  ja exit
+      jit_bytes("\xEB\x16", 2);                         //  jmp body
+      jit_sse("\xF2\x0F\x10", 0, a);                    //  down: movsd xmm0, [last]
+      jit_sse("\x66\x0F\x2E", 0, var);                  //  ucomisd xmm0, [var]
+      jit_bytes("\x0F\x87", 2); jit_rel32(cd.jmpAdrs);   //  ja exit
+      break;
+  case ForNext:
+      var = jit_local(Ltable[entryStk[cd.jmpAdrs][dp-3].sym].adrs);
+      jit_sse("\xF2\x0F\x10", 0, var);
+      jit_sse("\xF2\x0F\x58", 0, b);                    //  addsd xmm0, [step]
+      jit_sse("\xF2\x0F\x11", 0, var);
+      jit_bytes("\xE9", 1); jit_rel32(cd.jmpAdrs);
+      break;
+
+  case Fcall:                                           //  The arguments are in the slots from dp - args
+      jit_bytes("\x48\x8D\xB5", 3); jit_int32(jit_slot(dp - Gtable[cd.symNbr].args));   //  lea rsi, [rbp+d]
+      jit_bytes("\xBF", 1); jit_int32(cd.symNbr);       //  mov edi, fncNbr
+      jit_call((void *)jit_fcall);
+      jit_sse("\xF2\x0F\x11", 0, jit_slot(dp - Gtable[cd.symNbr].args));
+      jit_bytes("\x48\xB8", 2); jit_int64((long long)&exit_Flg);
+      jit_bytes("\x80\x38\x00", 3);                     //  cmp byte [rax], 0
+      jit_bytes("\x0F\x85", 2); jit_rel32(-1);          //  jne epilogue
+      break;
+  case RetVal:
+      jit_bytes("\x48\xB8", 2); jit_int64((long long)&returnValue);
+      jit_bytes("\x48\x8B\x00", 3);                     //  mov rax, [rax]
+      jit_store(t);
+      break;
+  case RetSet: case Return:
+      jit_load(b);
+      jit_bytes("\x48\xB9", 2); jit_int64((long long)&returnValue);
+      jit_bytes("\x48\x89\x01", 3);                     //  mov [rcx], rax
+      if (cd.kind == Return) jit_bytes("\xC9\xC3", 2);  //  leave ; ret
+      break;
+  default:
+      break;
+  }
+}
+
+
+/* Call of the function itself in tail position : the arguments in the slots from dp - args become
+   the parameters, and the body is run again in the same frame */
+void jit_selfTail(int fncNbr, int dp) {
+  int args = Gtable[fncNbr].args;
+  double d = 1.0;                                       //  Return value of a body ending without 'return'
+  long long bits;
+  char *save_ptr = code_ptr;                            //  param_sym() moves code_ptr
+
+  for (int n = 0; n < args; n++) {
+    jit_load(jit_slot(dp - args + n));
+    jit_store(jit_local(Ltable[param_sym(fncNbr, n)].adrs));
+  }
+  code_ptr = save_ptr;
+  memcpy(&bits, &d, sizeof(bits));
+  jit_bytes("\x48\xB8", 2); jit_int64(bits);           //  mov rax, imm64
+  jit_bytes("\x48\xB9", 2); jit_int64((long long)&returnValue);
+  jit_bytes("\x48\x89\x01", 3);                       //  mov [rcx], rax
+  jit_bytes("\xE9", 1); jit_rel32(fnc_body(fncNbr));   //  jmp body
+}
+
+
+/* Offset from rbp of the local at "adrs" in the frame, and of the k-th value of the operand stack */
+int jit_local(int adrs) { return -8 * (1 + adrs); }
+int jit_slot(int k)     { return -8 * (1 + jitFrame + k); }
+
+
+/* Boolean in al to 1.0 or 0.0 in the slot */
+void jit_bool(int slot) {
+  jit_bytes("\x0F\xB6\xC0", 3);                         //  movzx eax, al
+  jit_bytes("\xF2\x0F\x2A\xC0", 4);                     //  cvtsi2sd xmm0, eax
+  jit_sse("\xF2\x0F\x11", 0, slot);
+}
+
+
+/* Truth of the value in the slot to al (not zero, NaN included, as in C++) */
+void jit_truth(int slot) {
+  jit_sse("\xF2\x0F\x10", 0, slot);
+  jit_bytes("\x66\x0F\x57\xC9", 4);                     //  xorpd xmm1, xmm1
+  jit_bytes("\x66\x0F\x2E\xC1", 4);                     //  ucomisd xmm0, xmm1
+  jit_bytes("\x0F\x95\xC0\x0F\x9A\xC1\x08\xC8", 8);     //  setne al ; setp cl ; or al, cl
+}
+
+
+/* rax <-> slot */
+void jit_load(int slot)  { jit_bytes("\x48\x8B\x85", 3); jit_int32(slot); }   //  mov rax, [rbp+d]
+void jit_store(int slot) { jit_bytes("\x48\x89\x85", 3); jit_int32(slot); }   //  mov [rbp+d], rax
+
+
+/* SSE instruction "op" between xmm "reg" and the slot  (8 bytes) */
+void jit_sse(const char *op, int reg, int slot) {
+  jit_bytes(op, 3);
+  jitBuf.push_back(0x85 | (reg << 3));                  //  ModRM : [rbp+disp32]
+  jit_int32(slot);
+}
+
+
+/* Call of a C++ function  (12 bytes) */
+void jit_call(void *f) {
+  jit_bytes("\x48\xB8", 2); jit_int64((long long)f);    //  mov rax, imm64
+  jit_bytes("\xFF\xD0", 2);                             //  call rax
+}
+
+
+/* rel32 to the native code of the code at "adrs" (-1 : the epilogue) */
+void jit_rel32(int adrs) {
+  jitFix.push_back(make_pair((int)jitBuf.size(), adrs));
+  jit_int32(0);
+}
+
+
+void jit_bytes(const char *s, int len) { jitBuf.insert(jitBuf.end(), s, s + len); }
+void jit_int32(int n)       { jit_bytes((const char *)&n, 4); }
+void jit_int64(long long n) { jit_bytes((const char *)&n, 8); }
+
+
+/* Division by zero in the native code */
+void jit_divError(int adrs) {
+  Pc = adrs;
+  err_exit("Division by Zero");
+}
@@ -4,7 +4,7 @@
  *
  *      FILE NAME       :   peri_misc.cpp
  *
- *      OUTLINE         :   Error Output
+ *      OUTLINE         :   Error Output, Output and Input Buffers, Binary Files of Arrays
  *
  *      REQUIRED FILES  :   peri_misc.cpp
  *
@@ -17,6 +17,30 @@
 *********************************************************************************************************/
 #include "peri.h"
 #include "peri_prot.h"
+#include <charconv>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define IN_READ
+#define ARY_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+
+/* Define */
+#define OUT_BUF_SIZ 65536       //  Size of the output buffer
+#define IN_BUF_SIZ  65536       //  Bytes read from the standard input at once
+
+
+char outBuf[OUT_BUF_SIZ];       //  Output of print and println not written yet
+int  outLen;                    //  Bytes in outBuf
+bool lineBuf_F;                 //  If TRUE, write the output at every println (--line-buffered)
+vector<char> inBuf;             //  Standard input read but not used yet, from inPos to inEnd
+size_t inPos, inEnd;
+bool inEof;                     //  The standard input has ended
+const int fmtWidth[] = { 0, 8, 4, 4, 8 };   //  Bytes of an element of each ElmFmt
 
 
 /* Number to String */
@@ -41,6 +65,7 @@ string err_msg(const string& a, const string& b) {
 void err_exit(Tobj a, Tobj b, Tobj c, Tobj d) {
   Tobj ob[5];
   ob[1] = a; ob[2] = b; ob[3] = c; ob[4] = d;
+  out_flush();                                  //  The output so far comes before the error (cerr is tied to cout)
   cerr << "line:" << get_lineNo() << " ERROR ";
 
   for (int i=1; i<=4 && ob[i].s!="\1"; i++) {
@@ -50,3 +75,243 @@ void err_exit(Tobj a, Tobj b, Tobj c, Tobj d) {
   cout << endl;
   exit(1);
 }
+
+
+/* Output */
+/* print and println write into outBuf, which goes to the standard output in one write when it is
+   full, at the end of the program, before input(), by 'flush' and (--line-buffered) at println.
+   Numbers are formatted just as cout << d does ("%g" with 6 digits). */
+void out_str(const char *s, int len) {
+  if (outLen + len > OUT_BUF_SIZ) {
+    out_flush();
+    if (len > OUT_BUF_SIZ) { fwrite(s, 1, len, stdout); return; }
+  }
+  memcpy(outBuf + outLen, s, len);
+  outLen += len;
+}
+
+void out_dbl(double d) {
+  char *p;
+
+  if (outLen + 32 > OUT_BUF_SIZ) out_flush();
+  p = outBuf + outLen;
+  if (d > -1e6 && d < 1e6 && d == (long long)d && !(d == 0 && signbit(d))) {
+    p = to_chars(p, p + 32, (long long)d).ptr;          //  Integers are printed as they are by "%g"
+  }
+  else p = to_chars(p, p + 32, d, chars_format::general, 6).ptr;
+  outLen = p - outBuf;
+}
+
+void out_nl() {
+  if (outLen == OUT_BUF_SIZ) out_flush();
+  outBuf[outLen++] = '\n';
+  if (lineBuf_F) out_flush();
+}
+
+void out_flush() {
+  if (outLen > 0) fwrite(outBuf, 1, outLen, stdout);
+  outLen = 0;
+  fflush(stdout);
+}
+
+
+
+/* Input */
+/* input() and readarray() take the standard input from inBuf, which is filled by one read at a time
+   (so a terminal gives what has been typed), and the numbers are converted by from_chars. */
+double in_line() {
+  size_t len = 0;
+  double d;
+
+  out_flush();                                          //  The prompt is shown first
+  for (;;) {                                            //  Up to the end of the line
+    while (inPos + len < inEnd && inBuf[inPos + len] != '\n') len++;
+    if (inPos + len < inEnd || !in_fill()) break;
+  }
+  d = str_to_dbl(inBuf.data() + inPos, inBuf.data() + inPos + len);
+  inPos += len;
+  if (inPos < inEnd) inPos++;                           //  '\n'
+  return d;
+}
+
+
+/* readarray() : the numbers separated by blanks go into the elements from "mem", until "len" of them,
+   the end of the input or something not a number ; the count is returned */
+int read_array(Value *mem, int len, const char *fname) {
+  const char *s, *e;
+  vector<char> buf;
+  ifstream fin;
+  double d;
+  int cnt = 0;
+
+  if (*fname == '\0') {                                //  Standard input
+    out_flush();
+    while (cnt < len && in_token(&s, &e) && num_token(s, e, d)) mem[cnt++].d = d;
+    return cnt;
+  }
+  fin.open(fname, ios::in | ios::binary);
+  if (!fin) err_exit("The file cannot be opened : ", fname);
+  fin.seekg(0, ios::end); buf.resize((size_t)fin.tellg()); fin.seekg(0, ios::beg);
+  if (!buf.empty()) fin.read(buf.data(), buf.size());
+  for (s = buf.data(), e = s + buf.size(); cnt < len; s = e) {
+    while (s < buf.data() + buf.size() && isspace((unsigned char)*s)) s++;
+    for (e = s; e < buf.data() + buf.size() && !isspace((unsigned char)*e); e++) ;
+    if (s == e || !num_token(s, e, d)) break;
+    mem[cnt++].d = d;
+  }
+  return cnt;
+}
+
+
+/* Next token of the standard input (characters up to a blank), FALSE at the end */
+bool in_token(const char **s, const char **e) {
+  size_t len = 0;
+
+  for (;;) {
+    while (inPos < inEnd && isspace((unsigned char)inBuf[inPos])) inPos++;
+    if (inPos < inEnd || !in_fill()) break;
+  }
+  if (inPos == inEnd) return false;
+  for (;;) {
+    while (inPos + len < inEnd && !isspace((unsigned char)inBuf[inPos + len])) len++;
+    if (inPos + len < inEnd || !in_fill()) break;
+  }
+  *s = inBuf.data() + inPos; *e = *s + len;
+  inPos += len;
+  return true;
+}
+
+
+/* Read more of the standard input after what is left in inBuf, FALSE at the end */
+bool in_fill() {
+  long n;
+
+  if (inEof) return false;
+  if (inPos > 0) {                                      //  What is left goes to the head
+    memmove(inBuf.data(), inBuf.data() + inPos, inEnd - inPos);
+    inEnd -= inPos; inPos = 0;
+  }
+  if (inEnd == inBuf.size()) inBuf.resize(max((size_t)IN_BUF_SIZ, inBuf.size() * 2));
+#ifdef IN_READ
+  n = read(0, inBuf.data() + inEnd, inBuf.size() - inEnd);
+#else
+  n = fread(inBuf.data() + inEnd, 1, inBuf.size() - inEnd, stdin);
+#endif
+  if (n <= 0) { inEof = true; return false; }
+  inEnd += n;
+  return true;
+}
+
+
+/* Number at the head of the characters from s to e, as atof() reads it (0 if none) */
+double str_to_dbl(const char *s, const char *e) {
+  from_chars_result r;
+  double d = 0;
+
+  while (s < e && isspace((unsigned char)*s)) s++;
+  r = from_chars(s, e, d);
+  if (r.ec == errc() && (r.ptr == e || (*r.ptr != 'x' && *r.ptr != 'X'))) return d;
+  return atof(string(s, e).c_str());                    //  "+1", "0x1f", out of range
+}
+
+
+/* TRUE if the characters from s to e are a number as a whole, as strtod() reads it */
+bool num_token(const char *s, const char *e, double& d) {
+  from_chars_result r = from_chars(s, e, d);
+  string t;
+  char *end;
+
+  if (r.ec == errc() && r.ptr == e) return true;
+  t.assign(s, e);                                       //  "+1", "0x1f", out of range
+  d = strtod(t.c_str(), &end);
+  return *end == '\0';
+}
+
+
+/* Binary Files of Arrays */
+/* loadarray() maps the file and converts its elements into the array ; the pages are read by the
+   system as they are used.  storearray() maps the file made in the size of the array, writes the
+   elements into it and has them written to the disk (msync).  The count is returned. */
+int load_array(Value *mem, int len, const char *fname, int fmt) {
+  const char *p;
+  int cnt;
+#ifdef ARY_MMAP
+  struct stat st;
+  void *map = MAP_FAILED;
+  int fd;
+
+  if ((fd = open(fname, O_RDONLY)) < 0) err_exit("The file cannot be opened : ", fname);
+  if (fstat(fd, &st) != 0) st.st_size = 0;
+  cnt = (int)min((long long)len, (long long)st.st_size / fmtWidth[fmt]);
+  if (cnt > 0) map = mmap(NULL, (size_t)cnt * fmtWidth[fmt], PROT_READ, MAP_PRIVATE, fd, 0);
+  close(fd);
+  if (cnt > 0 && map == MAP_FAILED) err_exit("The file cannot be read : ", fname);
+  p = (const char *)map;
+  for (int n = 0; n < cnt; n++, p += fmtWidth[fmt]) mem[n].d = elm_get(p, fmt);
+  if (cnt > 0) munmap(map, (size_t)cnt * fmtWidth[fmt]);
+#else
+  ifstream fin(fname, ios::in | ios::binary);
+  char b[8];
+
+  if (!fin) err_exit("The file cannot be opened : ", fname);
+  for (cnt = 0, p = b; cnt < len && fin.read(b, fmtWidth[fmt]); cnt++) mem[cnt].d = elm_get(p, fmt);
+#endif
+  return cnt;
+}
+
+
+int store_array(Value *mem, int len, const char *fname, int fmt) {
+  char *p;
+#ifdef ARY_MMAP
+  size_t size = (size_t)len * fmtWidth[fmt];
+  void *map;
+  int fd;
+  bool ok;
+
+  if ((fd = open(fname, O_RDWR | O_CREAT | O_TRUNC, 0666)) < 0) err_exit("The file cannot be opened : ", fname);
+  ok = ftruncate(fd, size) == 0
+       && (map = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)) != MAP_FAILED;
+  close(fd);
+  if (!ok) err_exit("The file cannot be written : ", fname);
+  p = (char *)map;
+  for (int n = 0; n < len; n++, p += fmtWidth[fmt]) elm_put(p, mem[n].d, fmt);
+  ok = msync(map, size, MS_SYNC) == 0;
+  munmap(map, size);
+  if (!ok) err_exit("The file cannot be written : ", fname);
+#else
+  ofstream fout(fname, ios::out | ios::binary | ios::trunc);
+  char b[8];
+
+  if (!fout) err_exit("The file cannot be opened : ", fname);
+  for (int n = 0; n < len; n++) { p = b; elm_put(p, mem[n].d, fmt); fout.write(b, fmtWidth[fmt]); }
+  if (!fout.flush()) err_exit("The file cannot be written : ", fname);
+#endif
+  return len;
+}
+
+
+/* Element of a binary file to double, and back ; out of range for the integers is the least of them */
+double elm_get(const char *p, int fmt) {
+  double d; float f; int i; long long l;
+
+  switch (fmt) {
+  case FMT_F32: memcpy(&f, p, 4); return f;
+  case FMT_I32: memcpy(&i, p, 4); return i;
+  case FMT_I64: memcpy(&l, p, 8); return (double)l;
+  default:      memcpy(&d, p, 8); return d;
+  }
+}
+
+void elm_put(char *p, double d, int fmt) {
+  float f; int i; long long l;
+
+  switch (fmt) {
+  case FMT_F32: f = (float)d; memcpy(p, &f, 4); break;
+  case FMT_I32: i = (d > -2147483649.0 && d < 2147483648.0) ? (int)d : INT_MIN; memcpy(p, &i, 4); break;
+  case FMT_I64:
+      l = (d >= -9223372036854775808.0 && d < 9223372036854775808.0) ? (long long)d : LLONG_MIN;
+      memcpy(p, &l, 8);
+      break;
+  default:      memcpy(p, &d, 8); break;
+  }
+}
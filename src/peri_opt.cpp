@@ -0,0 +1,184 @@
+/********************************************************************************************************
+ *
+ *      PROJECT NAME    :   ASMI Demo Contest 2022
+ *
+ *      FILE NAME       :   peri_opt.cpp
+ *
+ *      OUTLINE         :   Optimization of the internal code (inline expansion)
+ *
+ *      REQUIRED FILES  :   peri.h, peri_prot.h
+ *
+ *      EDITOR : Taichi KATO,   Advanced Sensing & Machine Intelligence Group,  Chukyo Univ.
+ *
+ *      LAST UPDATED : Apl. 17, 2022
+ *
+ *      Copyright © 2022 Taichi KATO. All rights reserved.
+ *
+*********************************************************************************************************/
+/* Header File */
+#include "peri.h"
+#include "peri_prot.h"
+
+
+/* Define */
+#define INLINE_MAX 40                   //  Largest function body (number of codes) expanded at its calls
+
+
+vector<char> newCode;                   //  Internal code being rebuilt
+vector< pair<int,int> > newLines;       //  Code Address and Source Line No. in newCode
+vector< pair<int,int> > inlFix;         //  Jumps in newCode to be fixed (operand position, new address)
+map< pair<int,int>, int > inlSym;       //  Local of the callee copied into the caller ((caller, local), new local)
+extern vector<char> intercode;
+extern vector< pair<int,int> > srcLines;
+extern vector<SymTbl> Gtable;
+extern vector<SymTbl> Ltable;
+extern char *code_ptr;
+extern int startPc;
+
+
+/* Inline Expansion */
+/* Calls in function bodies to small functions that call nothing are replaced by a copy of the body.
+   The locals of the callee get slots at the end of the caller frame, so the copy runs in the caller
+   frame.  A return stores the return value (RetSet) and jumps to the end of the copy.
+   TRUE if the code has been rebuilt. */
+bool inline_calls() {
+  vector<char> inl(Gtable.size(), 0);                   //  The function is expanded at its calls
+  vector<int> owner(intercode.size() + 1, -1);          //  Function whose body has the code
+  vector<int> mapAdrs(intercode.size() + 1, -1);        //  New address of each code
+  vector< pair<int,int> > fix;                          //  Jumps to be fixed (operand position, old address)
+  int n, adrs, next, end;
+  bool found = false;
+  CodeSet cd;
+
+  for (n = 0; n < (int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind != fncId) continue;
+    end = fnc_end(n);
+    for (adrs = Gtable[n].adrs; adrs < end; adrs++) owner[adrs] = n;
+    inl[n] = inlinable(n);
+  }
+  for (code_ptr = &intercode[0]; code_ptr < &intercode[0] + intercode.size(); ) {
+    adrs = code_ptr - &intercode[0]; cd = nextCode();
+    if (cd.kind == Fcall && owner[adrs] != -1 && inl[cd.symNbr]) found = true;
+  }
+  if (!found) return false;
+
+  newCode.clear(); newLines.clear(); inlFix.clear(); inlSym.clear();
+  for (adrs = 0; adrs < (int)intercode.size(); adrs = next) {
+    code_ptr = &intercode[adrs]; cd = nextCode();
+    next = code_ptr - &intercode[0];
+    mapAdrs[adrs] = newCode.size();
+    if (cd.kind == Fcall && owner[adrs] != -1 && inl[cd.symNbr]) {
+      inline_body(owner[adrs], cd.symNbr);
+      continue;
+    }
+    inl_line(adrs_to_lineNo(adrs));
+    newCode.insert(newCode.end(), &intercode[adrs], &intercode[next]);
+    if (is_jump(cd.kind)) fix.push_back(make_pair((int)newCode.size() - OPR_SIZ, (int)cd.jmpAdrs));
+  }
+  mapAdrs[intercode.size()] = newCode.size();
+
+  for (n = 0; n < (int)fix.size(); n++) *OPR_P(&newCode[fix[n].first]) = mapAdrs[fix[n].second];
+  for (n = 0; n < (int)inlFix.size(); n++) *OPR_P(&newCode[inlFix[n].first]) = inlFix[n].second;
+  for (n = 0; n < (int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind == fncId) Gtable[n].adrs = mapAdrs[Gtable[n].adrs];
+  }
+  set_startPc(mapAdrs[startPc]);
+  intercode.swap(newCode);
+  srcLines.swap(newLines);
+  syntaxChk();                                          //  Depth of the operand stack for the new code
+  return true;
+}
+
+
+/* TRUE if the calls to the function can be replaced by its body */
+/* It is small, calls nothing, has no local arrays, assigns its locals before reading them (so the copies
+   need no zero filling or type setting) and returns only with the return value on the stack. */
+bool inlinable(int fncNbr) {
+  vector<int> depth(intercode.size(), -1);
+  int top = Gtable[fncNbr].adrs, end = fnc_end(fncNbr), cnt = 0;
+  CodeSet cd;
+
+  if (Gtable[fncNbr].name == "main") return false;
+  for (code_ptr = &intercode[top]; code_ptr < &intercode[end]; cnt++) {
+    cd = nextCode();
+    if (cd.kind == Fcall) return false;
+    if ((cd.kind == Lvar || cd.kind == Lset || cd.kind == Ladrs) && Ltable[cd.symNbr].aryLen != 0) return false;
+    if (cd.kind == Lread || cd.kind == Lwrite) return false;
+  }
+  if (cnt - Gtable[fncNbr].args > INLINE_MAX) return false;
+  if (!locals_assigned(fncNbr)) return false;
+
+  (void)chk_stkDepth(depth, top, Gtable[fncNbr].args);
+  for (code_ptr = &intercode[top]; code_ptr < &intercode[end]; ) {
+    int adrs = code_ptr - &intercode[0];
+    cd = nextCode();
+    if (cd.kind == Return && depth[adrs] > 1) return false;    //  Inside a 'for' (-1: never reached)
+  }
+  return true;
+}
+
+
+/* Copy of the body of the function "callee" at a call in "caller" */
+void inline_body(int caller, int callee) {
+  int top = Gtable[callee].adrs, end = fnc_end(callee), adrs, next, n;
+  vector<int> mapAdrs(end - top + 1, -1);               //  New address of each code of the callee (from top)
+  vector< pair<int,int> > fix, toEnd;
+  char *p;
+  CodeSet cd;
+
+  for (adrs = top; adrs < end; adrs = next) {
+    code_ptr = &intercode[adrs]; cd = nextCode();
+    next = code_ptr - &intercode[0];
+    mapAdrs[adrs - top] = newCode.size();
+    inl_line(adrs_to_lineNo(adrs));
+
+    switch (cd.kind) {
+    case RetVal:                                        //  A function that calls nothing still has 1.0
+        newCode.push_back(IntNum);
+        newCode.resize(newCode.size() + OPR_SIZ);
+        *OPR_P(&newCode[newCode.size() - OPR_SIZ]) = set_LITERAL(1.0);
+        break;
+    case Return:
+        newCode.push_back(RetSet);
+        if (next >= end) break;                         //  The end of the copy follows
+        newCode.push_back(Jump);
+        newCode.resize(newCode.size() + OPR_SIZ);
+        toEnd.push_back(make_pair((int)newCode.size() - OPR_SIZ, 0));
+        break;
+    default:
+        newCode.insert(newCode.end(), &intercode[adrs], &intercode[next]);
+        p = &newCode[0] + newCode.size() - OPR_SIZ;       //  Operand, if there is one
+        if (cd.kind == Lvar || cd.kind == Lset || cd.kind == Ladrs) *OPR_P(p) = inl_local(caller, callee, cd.symNbr);
+        if (is_jump(cd.kind)) fix.push_back(make_pair((int)(p - &newCode[0]), (int)cd.jmpAdrs));
+        break;
+    }
+  }
+  mapAdrs[end - top] = newCode.size();
+  for (n = 0; n < (int)fix.size(); n++)   inlFix.push_back(make_pair(fix[n].first, mapAdrs[fix[n].second - top]));
+  for (n = 0; n < (int)toEnd.size(); n++) inlFix.push_back(make_pair(toEnd[n].first, (int)newCode.size()));
+}
+
+
+/* Local of the caller standing for the local "sym" of the callee (one set of slots per caller and callee) */
+int inl_local(int caller, int callee, int sym) {
+  map< pair<int,int>, int >::iterator it = inlSym.find(make_pair(caller, sym));
+  SymTbl tb;
+
+  if (it != inlSym.end()) return it->second;
+  if (inlSym.find(make_pair(caller, -1 - callee)) == inlSym.end()) {   //  Slots of this callee in the caller frame
+    inlSym[make_pair(caller, -1 - callee)] = Gtable[caller].frame;
+    Gtable[caller].frame += Gtable[callee].frame;
+  }
+  tb = Ltable[sym];
+  tb.adrs += inlSym[make_pair(caller, -1 - callee)];
+  tb.dtTyp = NON_T;
+  Ltable.push_back(tb);
+  inlSym[make_pair(caller, sym)] = Ltable.size() - 1;
+  return Ltable.size() - 1;
+}
+
+
+/* Source line of the code being stored */
+void inl_line(int line) {
+  if (newLines.empty() || newLines.back().second != line) newLines.push_back(make_pair((int)newCode.size(), line));
+}
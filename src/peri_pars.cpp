@@ -18,10 +18,12 @@
 /* Header File */
 #include "peri.h"
 #include "peri_prot.h"
+#include <chrono>
 
 
 /* Define */
 #define NO_FIX_ADRS 0                  //  Mark that still undecided about the address
+#define NO_DEF_ARGS -1                 //  Number of arguments of a function called before its definition
 Token token;                           //  Token currently being processed
 SymTbl tmpTb;                          //  Temporary storage symbol table
 int blkNest;                           //  Depth of block
@@ -30,8 +32,16 @@ int mainTblNbr;                        //  Location of the symbol table for the
 int loopNest;                          //  Loop nest
 bool fncDecl_F;                        //  TRUE if function definition is being processed
 bool explicit_F;                       //  If TRUE, force the variable declaration
-char codebuf[LIN_SIZ+1], *codebuf_p;   //  For internally generated code work
-extern vector<char*> intercode;        //  Converted internal code storage
+bool memo_F;                           //  If TRUE, memoize the pure functions
+vector<char> codeArea;                 //  For internally generated code work (sized for the longest line)
+char *codebuf, *codebuf_p;             //  Top of codeArea, next position
+extern vector<char> intercode;         //  Converted internal code storage (one contiguous image)
+extern vector< pair<int,int> > srcLines;  //  Code address and source line No. of each statement
+vector<int> breakList;                 //  Jumps of 'break' waiting for the end of the loop
+vector< pair<int,int> > fwdCalls;      //  Calls before the definition (table No. of the function, number of arguments)
+vector<int> fwdLines;                  //  Source line No. of each of them
+extern vector<double> nbrLITERAL;      //  Numerical value literal storage
+extern bool lexRpt_F;                  //  Report the front end (--lex-report)
 
 
 /* Initial value setting */
@@ -39,8 +49,8 @@ void init() {
   initChTyp();  //  character class table
   mainTblNbr = -1;
   blkNest = loopNest = 0;
-  fncDecl_F = explicit_F = false;
-  codebuf_p = codebuf;
+  fncDecl_F = explicit_F = memo_F = false;
+  codebuf = codebuf_p = NULL; reserve_codebuf(0);
 }
 
 
@@ -49,81 +59,141 @@ void convert_to_internalCode(char *fname) {
   
   init();  //  Initialize the character type table, etc.
 
-  /* Register only the function definition name first */
-  fileOpen(fname);
-  while (token=nextLine_tkn(), token.kind != EofProg) {
-    if (token.kind == Func) {
-      token = nextTkn(); set_name(); enter(tmpTb, fncId);
-    }
-  }
-
-  /* Conversion to internal code */
-  push_intercode();   //  Line 0 is unnecessary and should be buried.
+  /* Conversion to internal code in one pass ; calls before the definition are checked at the end */
+  chrono::steady_clock::time_point start = chrono::steady_clock::now();
   fileOpen(fname);
   token = nextLine_tkn();
   while (token.kind != EofProg) {
     convert();
   }
+  chk_fwdCalls();
 
   /* Set the call code of the main function if there is one. */
-  set_startPc(1);                    //  Start execution from line 1.
+  set_startPc(0);                    //  Start execution from the top of the code
   if (mainTblNbr != -1) {
     set_startPc(intercode.size());   //  Start execution from main
-    setCode(Fcall, mainTblNbr); setCode('('); setCode(')');
-    push_intercode();
+    setCode(Fcall, mainTblNbr); setCode(Pop);
   }
+  setCode(EofProg);                  //  End of the program
+  push_intercode();
+  if (lexRpt_F) lex_report(chrono::duration<double>(chrono::steady_clock::now() - start).count());
 }
 
 /* Processes codes that appear only at the beginning. 
    The rest of the code is processed by convert_rest(). */
+/* Control statements are converted into conditional and unconditional jumps. */
+/* A constant condition stores no test, and the arms never executed are removed. */
 void convert() {
+  vector<int> endList;                                      //  Jumps to the end of the if chain
+  int patch_adrs, top_adrs, brk;
+  bool taken, live, cnst;
+  string cond;                                              //  Codes of the condition
+  TknKind kd;
+  double d;
+  CodeSet var;
 
   switch (token.kind) {
   case Option: optionSet(); break;  //  Option setting
   case Var:    varDecl();   break;  //  Variables declaration
   case Func:   fncDecl();   break;  //  Definition of function
-  case While: case For:
-        ++loopNest;
-        convert_block_set(); setCode_End();
+  case While:                                               //  top: cond JumpF exit  body  Jump top  exit:
+        ++loopNest; brk = breakList.size();
+        top_adrs = intercode.size();
+        token = nextTkn(); convert_expr();
+        if (is_literal(codebuf, codebuf_p, d)) {            //  Constant condition
+          codebuf_p = codebuf;
+          if (d == 0) {                                     //  Never executed
+            setCode_EofLine(); convert_deadBlock(); setCode_End();
+            --loopNest;
+            break;
+          }
+          patch_adrs = -1;                                  //  Unconditional loop
+        }
+        else patch_adrs = setCode(JumpF, NO_FIX_ADRS);      //  False End
+        setCode_EofLine();
+        convert_block();
+        setCode(Jump, top_adrs);                            //  Go Head
+        if (patch_adrs != -1) backPatch(patch_adrs, codeAdrs());
+        setCode_End();
+        backPatch_break(brk, intercode.size());             //  Next to end
         --loopNest;
         break;
-  case If:
-        convert_block_set();                                //  if
-        while (token.kind == Elif) { convert_block_set(); } //  elif
-        if (token.kind == Else)    { convert_block_set(); } //  else
+  case For:                                                 //  [adrs end step]  top: ForChk exit  body  ForNext top  exit:
+        ++loopNest; brk = breakList.size();
+        token = nextTkn(); set_name();
+        var = convert_var();                                //  Address of the control variable stays on the stack
+        convert_index(var); setCode(var.kind == Gvar ? Gadrs : Ladrs, var.symNbr);
+        if (tableP(var)->aryLen != 0) setCode(Dup);
+        token = chk_nextTkn(token, '='); convert_expr();    //  Initial Value
+        setCode(var.kind == Gvar ? Gset : Lset, var.symNbr);
+        token = chk_nextTkn(token, To); convert_expr();     //  Last Value
+        if (token.kind == Step) { token = nextTkn(); convert_expr(); }   //  Step Value
+        else setCode(IntNum, set_LITERAL(1.0));
+        top_adrs = codeAdrs();
+        patch_adrs = setCode(ForChk, NO_FIX_ADRS);
+        setCode_EofLine();
+        convert_block();
+        setCode(ForNext, top_adrs);                         //  Update Value and Go Head
+        backPatch(patch_adrs, codeAdrs());
+        backPatch_break(brk, codeAdrs());
+        setCode(Pop); setCode(Pop); setCode(Pop);           //  Remove the loop state
+        setCode_End();
+        --loopNest;
+        break;
+  case If:                                                  //  cond JumpF next  body  Jump end  next: ...
+        taken = live = false;                               //  An arm is always taken / An arm is stored
+        patch_adrs = -1;
+        for (kd = If; kd == If || kd == Elif || kd == Else; kd = token.kind) {
+          token = nextTkn();
+          if (kd != Else) convert_expr();
+          d = 1;                                            //  'else' is always taken
+          cnst = (kd == Else) || is_literal(codebuf, codebuf_p, d);
+          if (taken || (cnst && d == 0)) {                  //  The arm is never executed
+            codebuf_p = codebuf;
+            setCode_EofLine(); convert_deadBlock();
+          } else {
+            cond.assign(codebuf, codebuf_p); codebuf_p = codebuf;
+            if (live) endList.push_back(setCode(Jump, NO_FIX_ADRS));   //  End of the previous arm
+            if (patch_adrs != -1) backPatch(patch_adrs, codeAdrs());    //  Jump from the previous condition
+            patch_adrs = -1;
+            if (cnst) taken = true;                         //  No condition is needed
+            else {
+              memcpy(codebuf_p, cond.data(), cond.size()); codebuf_p += cond.size();
+              patch_adrs = setCode(JumpF, NO_FIX_ADRS);
+            }
+            live = true;
+            setCode_EofLine();
+            convert_block();
+          }
+          if (kd == Else) break;
+        }
         setCode_End();                                      //  end
+        if (patch_adrs != -1) backPatch(patch_adrs, intercode.size());
+        for (int n=0; n<(int)endList.size(); n++) backPatch(endList[n], intercode.size());
         break;
   case Break:
         if (loopNest <= 0) err_exit("Incorrect 'break' error.");
-        setCode(token.kind); token = nextTkn(); convert_rest();
+        convert_rest(token.kind);
         break;
   case Return:
         if (!fncDecl_F) err_exit("Incorrect 'return' error.");
-        setCode(token.kind); token = nextTkn(); convert_rest();
-        break;
-  case Exit:
-        setCode(token.kind); token = nextTkn(); convert_rest();
-        break;
-  case Print: case Println:
-        setCode(token.kind); token = nextTkn(); convert_rest();
+        convert_rest(token.kind);
         break;
   case End:
        err_exit("Incorrect 'end' error.");  //  'end' is never used by itself.
         break;
-  default: convert_rest(); break;
+  default: convert_rest(token.kind); break;   //  Assignment, function call, print, exit or empty line
   }
 }
 
 
-/* Block process management */
-void convert_block_set() {
+/* Block that is never executed : it is converted for checking, then removed */
+void convert_deadBlock() {
+  int adrs = intercode.size(), lines = srcLines.size();
 
-  int patch_line;
-
-  patch_line = setCode(token.kind, NO_FIX_ADRS); token = nextTkn();
-  convert_rest();
-  convert_block();                      //  Block processing
-  backPatch(patch_line, get_lineNo());  //  Fix NO_FIX_ADRS (end line number)　
+  convert_block();
+  intercode.resize(adrs); srcLines.resize(lines);
+  while (!breakList.empty() && breakList.back() >= adrs) breakList.pop_back();
 }
 
 
@@ -140,55 +210,334 @@ void convert_block() {
 
 
 /* Processing the rest of the statement */
-void convert_rest() {
+/* Expressions are stored in evaluation (postfix) order, followed by the code that uses the value. */
+void convert_rest(TknKind kd) {
+  int tblNbr, patch_adrs;
+  char *top;
+  double d;
+  CodeSet var;
+
+  switch (kd) {
+  case Return:                                                //  value [cond JumpF L] Return L: Pop
+      token = nextTkn();
+      if (token.kind != '?' && token.kind != EofLine) convert_expr();   //  Return value
+      else setCode(RetVal);                                   //  The current return value
+      if (token.kind == '?') {
+        top = codebuf_p;
+        token = nextTkn(); convert_expr();
+        if (is_literal(top, codebuf_p, d)) {                  //  Constant condition
+          codebuf_p = top;
+          setCode(d != 0 ? Return : Pop);
+          break;
+        }
+        patch_adrs = setCode(JumpF, NO_FIX_ADRS);
+        setCode(Return);
+        backPatch(patch_adrs, codeAdrs());
+        setCode(Pop);
+      }
+      else setCode(Return);
+      break;
+  case Break:                                                 //  Jump to the end of the loop
+      token = nextTkn();
+      d = 1;
+      if (token.kind == '?') { token = nextTkn(); convert_expr(); }
+      if (codebuf_p == codebuf || is_literal(codebuf, codebuf_p, d)) {    //  No condition or a constant one
+        codebuf_p = codebuf;
+        if (d != 0) breakList.push_back(setCode(Jump, NO_FIX_ADRS));
+      }
+      else breakList.push_back(setCode(JumpT, NO_FIX_ADRS));
+      break;
+  case Print: case Println:
+      token = nextTkn();
+      for (;;) {
+        if (token.kind == String) { setCode(String, set_LITERAL(string(token.text))); token = nextTkn(); }
+        else { convert_expr(); setCode(Print); }              //  Output the value on the stack
+        if (token.kind != ',') break;                         //  If there is "," , parameter follows
+        token = nextTkn();
+      }
+      if (kd == Println) setCode(Println);
+      break;
+  case Exit:
+      token = nextTkn(); setCode(Exit);
+      break;
+  case Flush:                                                 //  Write the output so far
+      token = nextTkn(); setCode(Flush);
+      break;
+  case Readarray: case Loadarray: case Storearray:          //  The count is not used
+      convert_readarray(); setCode(Pop);
+      break;
+  case Elif:                                                  //  Out of place
+      convert_expr();
+      break;
+  case Else: case EofLine:                                    //  Nothing follows
+      break;
+  default:                                                    //  Function call, assignment
+      set_name();
+      if ((tblNbr=fnc_name()) != -1) {
+        convert_fncCall(tblNbr); setCode(Pop);                //  No Return Value Required
+      } else {
+        var = convert_var();
+        if (tableP(var)->aryLen != 0) { convert_index(var); setCode(var.kind == Gvar ? Gadrs : Ladrs, var.symNbr); }
+        token = chk_nextTkn(token, '='); convert_expr();
+        setCode(var.kind == Gvar ? Gset : Lset, var.symNbr);
+      }
+      break;
+  }
+  setCode_EofLine();
+}
+
+
+/* Expression */
+void convert_expr() {
+  convert_term(1);
+}
+
+
+/* n is the Order of Priority */
+/* An operation on literals is folded into one literal */
+void convert_term(int n) {
+  TknKind op;
+  char *left, *right;
+  double d1, d2;
+
+  if (n == 7) { convert_factor(); return; }
+  left = codebuf_p;
+  convert_term(n + 1);
+  while (n == opOrder(token.kind)) {    //  Followed by Operands of Equal Strength
+    op = token.kind;
+    right = codebuf_p;
+    token = nextTkn(); convert_term(n + 1);
+    if (is_literal(left, right, d1) && is_literal(right, codebuf_p, d2) && fold_binary(op, d1, d2)) {
+      codebuf_p = left;
+      setCode(DblNum, set_LITERAL(d1));
+    }
+    else setCode(op);                   //  Operator is stored after both operands
+  }
+}
+
+
+/* TRUE if the codes from p to q are one numeric literal, whose value is set to d */
+bool is_literal(char *p, char *q, double& d) {
+  if (q - p != 1 + (int)OPR_SIZ || (*UCHAR_P(p) != IntNum && *UCHAR_P(p) != DblNum)) return false;
+  d = nbrLITERAL[*OPR_P(p + 1)];
+  return true;
+}
+
+
+/* Binary operation on literals, the result is set to d1 */
+/* Division by zero is left to be reported at execution (so is what the processor cannot divide in int) */
+bool fold_binary(TknKind op, double& d1, double d2) {
+  if ((op == Divi || op == Mod || op == IntDivi) && d2 == 0) return false;
+  if ((op == Mod || op == IntDivi) && ((int)d2 == 0 || ((int)d1 == INT_MIN && (int)d2 == -1))) return false;
+
+  switch (op) {
+  case Plus:    d1 = d1 + d2;  break;
+  case Minus:   d1 = d1 - d2;  break;
+  case Multi:   d1 = d1 * d2;  break;
+  case Divi:    d1 = d1 / d2;  break;
+  case Mod:     d1 = (int)d1 % (int)d2; break;
+  case IntDivi: d1 = (int)d1 / (int)d2; break;
+  case Less:    d1 = d1 <  d2; break;
+  case LessEq:  d1 = d1 <= d2; break;
+  case Great:   d1 = d1 >  d2; break;
+  case GreatEq: d1 = d1 >= d2; break;
+  case Equal:   d1 = d1 == d2; break;
+  case NotEq:   d1 = d1 != d2; break;
+  case And:     d1 = d1 && d2; break;
+  case Or:      d1 = d1 || d2; break;
+  default:      return false;
+  }
+  return true;
+}
+
+
+/* Factor */
+void convert_factor() {
   int tblNbr;
+  char *top;
+  double d;
+  CodeSet var;
+  TknKind kd = token.kind;
+
+  switch (kd) {
+  case Not: case Minus: case Plus:
+      top = codebuf_p;
+      token = nextTkn(); convert_factor();
+      if (kd != Plus && is_literal(top, codebuf_p, d)) {      //  Folded into a literal
+        codebuf_p = top;
+        setCode(DblNum, set_LITERAL(kd == Not ? !d : -d));
+      }
+      else if (kd == Not)   setCode(Not);
+      else if (kd == Minus) setCode(Uminus);                  //  If unary +, nothing to do
+      break;
+  case Lparen:
+      token = nextTkn(); convert_expr();
+      token = chk_nextTkn(token, ')');
+      break;
+  case IntNum: case DblNum:                                   //  Integers are also stored as double type
+      setCode(kd, set_LITERAL(token.dblVal)); token = nextTkn();
+      break;
+  case Ident:
+      set_name();
+      if ((tblNbr=fnc_name()) != -1) convert_fncCall(tblNbr);
+      else {
+        var = convert_var();
+        convert_index(var); setCode(var.kind, var.symNbr);    //  The index is stored before the variable
+      }
+      break;
+  case Toint:
+      top = codebuf_p;
+      token = chk_nextTkn(nextTkn(), '('); convert_expr();
+      token = chk_nextTkn(token, ')');
+      if (is_literal(top, codebuf_p, d)) { codebuf_p = top; setCode(DblNum, set_LITERAL((int)d)); }
+      else setCode(Toint);
+      break;
+  case Input:
+      token = chk_nextTkn(nextTkn(), '('); token = chk_nextTkn(token, ')');
+      setCode(Input);
+      break;
+  case Readarray: case Loadarray: case Storearray:
+      convert_readarray();
+      break;
+  case EofLine:
+      err_exit("Incorrect Expression");
+  default:
+      err_exit("Expression Error:", token.text);              //  Occurs for a, +, =, etc...
+  }
+}
 
-  for (;;) {
-    if (token.kind == EofLine) break;
-    /* These keywords do not appear in the text. */
-    switch (token.kind) {
-    case If: case Elif: case Else: case For: case While: case Break:
-    case Func:  case Return:  case Exit:  case Print:  case Println:
-    case Option: case Var: case End:
-        err_exit("Incorrect description error.", token.text);
-        break;
-    case Ident:
-        set_name();                                         //  Function call, variables 
-        if ((tblNbr=searchName(tmpTb.name, 'F')) != -1) {   //  If the function is registered
-          if (tmpTb.name == "main") err_exit("main function cannot be called.");
-          setCode(Fcall, tblNbr); continue;
-        }
-        if ((tblNbr=searchName(tmpTb.name, 'V')) == -1) {   //  If the variable is not registered 
-          if (explicit_F) err_exit("Variable declaration is required : ", tmpTb.name);
-          tblNbr = enter(tmpTb, varId);                     //  Auto variable registration  
-        }
-        if (is_localName(tmpTb.name, varId)) setCode(Lvar, tblNbr);
-        else                                 setCode(Gvar, tblNbr);
-        continue;
-    case IntNum: case DblNum:                               //  Integers are also stored as double type 
-        setCode(token.kind, set_LITERAL(token.dblVal));
-        break;
-    case String:
-        setCode(token.kind, set_LITERAL(token.text));
-        break;
-    default:
-        setCode(token.kind);                                //  * + - / < <= > >=   etc... //
-        break;
+
+/* Precedence of Binary Operands */
+int opOrder(TknKind kd) {
+    switch (kd) {
+    case Multi: case Divi: case Mod:
+    case IntDivi:                    return 6;    //  * / % ¥
+    case Plus:  case Minus:          return 5;    //  + -
+    case Less:  case LessEq:
+    case Great: case GreatEq:        return 4;    //  < <=  > >=
+    case Equal: case NotEq:          return 3;    //  ==  !=
+    case And:                        return 2;    //  &&
+    case Or:                         return 1;    //  ||
+    default:                         return 0;    //  Not applicable
     }
+}
+
+
+/* Variable whose name is in tmpTb */
+/* Returns Gvar or Lvar with its table No. ; the caller stores the code that uses it */
+CodeSet convert_var() {
+  int tblNbr;
+
+  if ((tblNbr=searchName(tmpTb.name, 'V')) == -1) {           //  If the variable is not registered
+    if (explicit_F) err_exit("Variable declaration is required : ", tmpTb.name);
+    tblNbr = enter(tmpTb, varId);                             //  Auto variable registration
+  }
+  return CodeSet(is_localName(tmpTb.name, varId) ? Lvar : Gvar, tblNbr, -1);
+}
+
+
+/* Index of the array, nothing for a simple variable */
+void convert_index(const CodeSet& var) {
+  if (tableP(var)->aryLen == 0) return;
+  token = chk_nextTkn(token, '['); convert_expr();
+  token = chk_nextTkn(token, ']');
+}
+
+
+/* readarray(array [, "file"]) , loadarray(array, "file" [, "type"]) , storearray(array, "file" [, "type"]) */
+/* Gread/Lread and Gwrite/Lwrite have the array, the file name ("" : the standard input) and the format,
+   and leave the count of the elements read or written.  The type of the binary files is "double"
+   (by default), "float", "int32" or "int64". */
+void convert_readarray() {
+  static const char *fmtName[] = { "", "double", "float", "int32", "int64" };
+  TknKind kd = token.kind;
+  CodeSet var;
+  int lit, fmt = (kd == Readarray) ? FMT_TEXT : FMT_F64;
+
+  token = chk_nextTkn(nextTkn(), '(');
+  set_name(); var = convert_var();
+  if (tableP(var)->aryLen == 0) err_exit(kind_to_s(kd), " requires an array : ", tmpTb.name);
+  if (kd == Readarray && token.kind != ',') lit = set_LITERAL("");   //  The standard input
+  else {
+    token = chk_nextTkn(token, ',');
+    if (token.kind != String) err_exit("Specify the file name as a string : ", token.text);
+    lit = set_LITERAL(string(token.text)); token = nextTkn();
+  }
+  if (kd != Readarray && token.kind == ',') {
+    token = nextTkn();
+    for (fmt = FMT_F64; fmt <= FMT_I64 && token.text != fmtName[fmt]; fmt++) ;
+    if (token.kind != String || fmt > FMT_I64) err_exit("Specify the type as \"double\", \"float\", \"int32\" or \"int64\" : ", token.text);
     token = nextTkn();
   }
-  push_intercode();
-  token = nextLine_tkn();
+  token = chk_nextTkn(token, ')');
+  if (kd == Storearray) setCode(var.kind == Gvar ? Gwrite : Lwrite, var.symNbr);
+  else                  setCode(var.kind == Gvar ? Gread : Lread, var.symNbr);
+  setCode_adrs(lit); setCode_adrs(fmt);
+}
+
+
+/* Function call */
+/* Fcall is stored after the arguments, and leaves the return value */
+void convert_fncCall(int fncNbr) {
+  extern vector<SymTbl> Gtable;               //  Global symbol table
+  int argCt = 0;
+
+  if (tmpTb.name == "main") err_exit("main function cannot be called.");
+  token = chk_nextTkn(token, '(');
+  if (token.kind != ')') {                    //  There are Arguments
+    for (;; token=nextTkn()) {
+      convert_expr(); ++argCt;                //  Argument expression and argument count
+      if (token.kind != ',') break;           //  If there is a "," , argument follows.
+    }
+  }
+  token = chk_nextTkn(token, ')');            //  It should be ")"
+  if (Gtable[fncNbr].args == NO_DEF_ARGS) {   //  Not defined yet : checked at the end
+    fwdCalls.push_back(make_pair(fncNbr, argCt)); fwdLines.push_back(get_lineNo());
+  }
+  else if (argCt != Gtable[fncNbr].args)      //  Checking the number of arguments
+    err_exit(Gtable[fncNbr].name, "The number of arguments for the function is wrong.");
+  setCode(Fcall, fncNbr);
+}
+
+
+/* Function of the name in tmpTb, -1 if it is not a function */
+/* A name not known yet and followed by "(" is a function defined later ; it is registered
+   here, and fncDecl() fills in the entry. */
+int fnc_name() {
+  extern vector<SymTbl> Gtable;
+  int n;
+
+  if ((n = searchName(tmpTb.name, 'F')) != -1) return n;
+  if (token.kind != '(' || tmpTb.name[0] == '$' || searchName(tmpTb.name, 'V') != -1) return -1;
+  n = enter(tmpTb, fncId);
+  Gtable[n].args = NO_DEF_ARGS;
+  return n;
+}
+
+
+/* Calls before the definition : the function must have been defined with as many arguments */
+void chk_fwdCalls() {
+  extern vector<SymTbl> Gtable;
+  extern int srcLineno;
+
+  for (int n = 0; n < (int)fwdCalls.size(); n++) {
+    srcLineno = fwdLines[n];                  //  Reported at the call
+    SymTbl& f = Gtable[fwdCalls[n].first];
+    if (f.args == NO_DEF_ARGS) err_exit("The function is not defined : ", f.name);
+    if (f.args != fwdCalls[n].second) err_exit(f.name, "The number of arguments for the function is wrong.");
+  }
 }
 
 
 /* Option Setting */
 void optionSet() {
 
-  setCode(Option);    //  This line is non-executable, so the only code translation is Option  
-  setCode_rest();     //  Store the rest in the original 
-  token = nextTkn();  //  Force variable declaration
+  token = nextTkn();  //  This line is non-executable, so no code is stored
+  //  Force variable declaration
   if (token.kind==String && token.text=="var") explicit_F = true;
+  //  Memoization of pure functions
+  else if (token.kind==String && token.text=="memo")   memo_F = true;
+  else if (token.kind==String && token.text=="nomemo") memo_F = false;
   else err_exit("The Option specification is incorrect.");
   token = nextTkn();
   setCode_EofLine();
@@ -197,9 +546,7 @@ void optionSet() {
 
 /* Declaring variables that use var */
 void varDecl() {
-  setCode(Var);                     //  This line is non-executable, so the only code translation is Var
-  setCode_rest();                   //  Store the rest in the original
-  for (;;) {
+  for (;;) {                        //  This line is non-executable, so no code is stored
     token = nextTkn();
     var_namechk(token);             //  Name checking
     set_name(); set_aryLen();       //  For arrays, set the length  
@@ -212,10 +559,10 @@ void varDecl() {
 
 /* Name Checking */
 void var_namechk(const Token& tk) {
-  if (tk.kind != Ident) err_exit(err_msg(tk.text, "Identifier"));
+  if (tk.kind != Ident) err_exit(err_msg(string(tk.text), "Identifier"));
   if (is_localScope() && tk.text[0] == '$')
     err_exit("Names with $ cannot be specified in var declarations in functions : ", tk.text);
-  if (searchName(tk.text, 'V') != -1)
+  if (searchName(string(tk.text), 'V') != -1)
     err_exit("Identifiers are duplicated : ", tk.text);
 }
 
@@ -243,40 +590,48 @@ void set_aryLen() {
 
 
 /* Function Def */
+/* Func jumps over the definition ; the entry stores the arguments, which are on the stack, in reverse order */
 void fncDecl() {
   extern vector<SymTbl> Gtable;             //  Global symbol table  
-  int tblNbr, patch_line, fncTblNbr;
+  extern unordered_map<string,int> localNames;   //  Every local name so far
+  vector<int> params;                       //  Table No. of the arguments
+  int patch_adrs, fncTblNbr;
 
   if(blkNest > 0) err_exit("The position of the function definition is incorrect.");
   fncDecl_F = true;                         //  Function processing start flag  
   localAdrs = 0;                            //  Local area allocation counter initialization  
   set_startLtable();                        //  Local symbol table start position  
-  patch_line = setCode(Func, NO_FIX_ADRS);  //  The end line number will be stored later  
-  token = nextTkn();
-
-  fncTblNbr = searchName(token.text, 'F');  //  Function names are registered at the beginning
+  patch_adrs = setCode(Func, NO_FIX_ADRS);  //  The end address will be stored later  
+  token = nextTkn(); set_name();
+
+  if (localNames.count(tmpTb.name))         //  No local so far may have the name
+    err_exit("This is a duplicate of the function name : ", tmpTb.name);
+  fncTblNbr = searchName(tmpTb.name, 'F');  //  Already registered if it has been called
+  if (fncTblNbr == -1 || Gtable[fncTblNbr].args != NO_DEF_ARGS)
+    fncTblNbr = enter(tmpTb, fncId);        //  Reports the name already used
   Gtable[fncTblNbr].dtTyp = DBL_T;          //  Function type is fixed to double  
+  Gtable[fncTblNbr].adrs = codeAdrs();      //  Address that function starts
 
-
-  token = nextTkn();                        //  Dummy argument analysis
   token = chk_nextTkn(token, '(');          //  It should be "("      
-  setCode('(');
+  Gtable[fncTblNbr].args = 0;               //  Counted again with the registration of arguments
   if (token.kind != ')') {                  //  There are arguments 
     for (;; token=nextTkn()) {
       set_name();
-      tblNbr = enter(tmpTb, paraId);        //  Arguments registration  
-      setCode(Lvar, tblNbr);                //  Arguments are processed as Lvar  
+      params.push_back(enter(tmpTb, paraId));   //  Arguments registration  
       ++Gtable[fncTblNbr].args;             //  Increase the number of arguments by 1
       if (token.kind != ',') break;         //  End of declarations
-      setCode(',');
     }
   }
   token = chk_nextTkn(token, ')');          //  It should be ")"    
-  setCode(')'); setCode_EofLine();
+  for (int n=params.size()-1; n>=0; n--) {
+    setCode(Lset, params[n]);               //  Arguments are processed as Lvar  
+  }
+  setCode_EofLine();
   convert_block();                          //  Function body processing  
 
-  backPatch(patch_line, get_lineNo());
+  setCode(RetVal); setCode(Return);         //  Return at the end of the function
   setCode_End();
+  backPatch(patch_adrs, intercode.size());  //  Next to end
   Gtable[fncTblNbr].frame = localAdrs;      //  Frame size
 
   if (Gtable[fncTblNbr].name == "main") {   //  main function processing
@@ -288,9 +643,23 @@ void fncDecl() {
 }
 
 
-/* Set the n for "line" */
-void backPatch(int line, int n) {
-  *SHORT_P(intercode[line] + 1) = (short)n;
+/* Set n to the address "adrs" */
+/* The address may be in the statement still being converted */
+void backPatch(int adrs, int n) {
+  char *p;
+
+  if (adrs >= (int)intercode.size()) p = codebuf + (adrs - intercode.size());
+  else                               p = &intercode[adrs];
+  *OPR_P(p) = n;
+}
+
+
+/* Fix the jumps of 'break' in the loop to "n" */
+void backPatch_break(int brk, int n) {
+  while ((int)breakList.size() > brk) {
+    backPatch(breakList.back(), n);
+    breakList.pop_back();
+  }
 }
 
 
@@ -300,26 +669,31 @@ void setCode(int cd) {
 }
 
 
-/* Store code & SHORT value */
+/* Store code & operand */
 int setCode(int cd, int nbr) {
   *codebuf_p++ = (char)cd;
-  *SHORT_P(codebuf_p) = (short)nbr; codebuf_p += SHORT_SIZ;
-  return get_lineNo();    //  Return the storing line for "backpatch"
+  return setCode_adrs(nbr);
+}
+
+
+/* Store operand */
+int setCode_adrs(int nbr) {
+  int adrs = codeAdrs();
+  *OPR_P(codebuf_p) = nbr; codebuf_p += OPR_SIZ;
+  return adrs;            //  Return the storing address for "backpatch"
 }
 
 
-/* Store the rest of the text as is */
-void setCode_rest() {
-  extern char *token_p;
-  strcpy(codebuf_p, token_p);
-  codebuf_p += strlen(token_p) + 1;
+/* Address where the next code is stored */
+int codeAdrs() {
+  return intercode.size() + (codebuf_p - codebuf);
 }
 
 
 /* Storing "end" processing */
 void setCode_End() {
-  if (token.kind != End) err_exit(err_msg(token.text, "end"));
-  setCode(End); token = nextTkn(); setCode_EofLine();
+  if (token.kind != End) err_exit(err_msg(string(token.text), "end"));
+  token = nextTkn(); setCode_EofLine();
 }
 
 
@@ -332,24 +706,32 @@ void setCode_EofLine() {
 
 
 /* Storing the converted internal code */
+/* Statements are appended to one contiguous image ; lines without code are not stored */
 void push_intercode() {
-  int len;
-  char *p;
-
-  *codebuf_p++ = '\0';
-  if ((len = codebuf_p-codebuf) >= LIN_SIZ)
-    err_exit("The converted internal code is incorrect. Please shorten the expression.");
+  if (codebuf_p == codebuf) return;     //  Empty line, option, var
 
   try {
-    p = new char[len];                  //  Securing memory
-    memcpy(p, codebuf, len);
-    intercode.push_back(p);
+    srcLines.push_back(make_pair((int)intercode.size(), get_lineNo()));
+    intercode.insert(intercode.end(), codebuf, codebuf_p);
   }
   catch (bad_alloc) { err_exit("Unable to allocate memory."); }
   codebuf_p = codebuf;                  //  Positioning at the beginning of the storage location for the next process.
 }
 
 
+/* Room in codebuf for the code of a source line of "len" characters */
+/* A character never makes more than a few codes, so the statement fits without being checked.
+   Lines are read when codebuf holds no pointer of the parser, so it may move here. */
+void reserve_codebuf(int len) {
+  int used = codebuf_p - codebuf;
+  size_t need = used + (size_t)(len + 8) * 4 * (1 + OPR_SIZ);
+
+  if (need <= codeArea.size()) return;
+  codeArea.resize(need);
+  codebuf = &codeArea[0]; codebuf_p = codebuf + used;
+}
+
+
 /* TRUE if the function is in process */
 bool is_localScope(){
   return fncDecl_F;
@@ -19,22 +19,37 @@
 void init();
 void convert_to_internalCode(char *fname);
 void convert();
-void convert_block_set();
+void convert_deadBlock();
 void convert_block();
-void convert_rest();
+void convert_rest(TknKind kd);
+void convert_expr();
+void convert_term(int n);
+bool is_literal(char *p, char *q, double& d);
+bool fold_binary(TknKind op, double& d1, double d2);
+void convert_factor();
+int opOrder(TknKind kd);
+CodeSet convert_var();
+void convert_index(const CodeSet& var);
+void convert_readarray();
+void convert_fncCall(int fncNbr);
+int fnc_name();
+void chk_fwdCalls();
 void optionSet();
 void varDecl();
 void var_namechk(const Token& tk);
 void set_name();
 void set_aryLen();
 void fncDecl();
-void backPatch(int line, int n);
+void backPatch(int adrs, int n);
+void backPatch_break(int brk, int n);
 void setCode(int cd);
 int setCode(int cd, int nbr);
-void setCode_rest();
+int setCode_adrs(int nbr);
+int codeAdrs();
 void setCode_End();
 void setCode_EofLine();
 void push_intercode();
+void reserve_codebuf(int len);
 bool is_localScope();
 void DBG_dump_src(char *s);
 void DBG_all_prog_disp();
@@ -43,11 +58,15 @@ void DBG_all_prog_disp();
 /* peri_tkn.cpp (TOKEN PROCESSING) */
 void initChTyp();
 void fileOpen(char *fname);
+void memOpen(char *text, size_t len);
 void nextLine();
+void munmap_src();
 Token nextLine_tkn();
 Token nextTkn();
+void lex_report(double sec);
 bool is_ope2(char c1, char c2);
-TknKind get_kind(const string& s);
+TknKind get_kind(string_view s);
+int kw_hash(string_view s);
 Token chk_nextTkn(const Token& tk, int kind2);
 void set_token_p(char *p);
 string DBG_kind_to_s(int kd);
@@ -68,40 +87,151 @@ void DBG_disp_SymTbl();
 
 /* peri_code.cpp (MEMORY MANAGEMENT & SYNTAX CHECKING & EXECUTION) */
 void syntaxChk();
+int chk_stkDepth(vector<int>& depth, int adrs, int n);
+int stkEffect(const CodeSet& cd, int& need);
 void set_startPc(int n);
 void execute();
-void statement();
-void block();
-double get_expression(int kind1=0, int kind2=0);
-void expression(int kind1, int kind2);
-void expression();
-void term(int n);
-void factor();
-int opOrder(TknKind kd);
-void binaryExpr(TknKind op);
-void post_if_set(bool& flg);
-void fncCall_syntax(int fncNbr);
-void fncCall(int fncNbr);
+void thread_code();
+int thr_fuse(const vector<CodeSet>& cds, const vector<int>& adrs, const vector<int>& target, int n);
+bool is_jump(TknKind kd);
+bool is_compare(TknKind kd);
+int fnc_body(int fncNbr);
+bool is_tailCall(const vector<CodeSet>& cds, const vector<int>& codeNo, int n);
+bool thr_for(const vector<CodeSet>& cds, const vector<int>& adrs, const vector<int>& codeNo, int n);
+int for_step(const vector<CodeSet>& cds, const vector<int>& adrs, const vector<int>& codeNo, int n);
+int int_kind(TknKind kd);
+int unchecked_kind(TknKind kd);
+int direct_kind(TknKind kd);
+bool compare(int op, double d1, double d2);
+bool compare(int op, long long i1, long long i2);
+void thr_code(int kd, int adrs);
+void thr_fused(int kd, int base, int adrs);
+void thr_int(int n, int adrs);
+void thr_dbl(double d, int adrs);
+void thr_i64(long long i, int adrs);
+void thr_str(const char *s, int adrs);
+void thr_jmp(int jmpAdrs, int adrs);
+void fusion_report();
+void run(Icell *pc);
 void fncExec(int fncNbr);
-void sysFncExec_syntax(TknKind kd);
-void sysFncExec(TknKind kd);
-int get_memAdrs(const CodeSet& cd);
-int get_topAdrs(const CodeSet& cd);
-int endline_of_If(int line);
-void chk_EofLine();
-TknKind lookCode(int line);
-CodeSet chk_nextCode(const CodeSet& cd, int kind2);
-CodeSet firstCode(int line);
+MemoEnt *memo_find(int fncNbr, const Value *key);
+double jit_fcall(int fncNbr, const double *arg);
+int ary_element(Icell *pc);
+void ary_error(Icell *pc);
+void chk_index(double d, int len);
+int adrs_to_lineNo(int adrs);
 CodeSet nextCode();
-void chk_dtTyp(const CodeSet& cd);
-void set_dtTyp(const CodeSet& cd, char typ);
+void set_dtTyp(SymTbl *p, int memAdrs, char typ);
 int set_LITERAL(double d);
 int set_LITERAL(const string& s);
 void DBG_stk();
 
-/* peri_misc.cpp (ERROR HANDLING) */
+/* peri_type.cpp (ANALYSIS OF THE INTERNAL CODE) */
+void infer_types();
+vector<AbsVal> param_stack(int fncNbr);
+int param_sym(int fncNbr, int k);
+void infer_region(int adrs, const vector<AbsVal>& st);
+bool join_stack(int adrs, vector<AbsVal>& stk);
+bool infer_code(int adrs, const CodeSet& cd, vector<AbsVal>& stk);
+void infer_for(int adrs, const CodeSet& cd, vector<AbsVal>& stk);
+bool for_stored(int top, int end, const AbsVal& var);
+Range loop_range(int adrs, const CodeSet& cd);
+void for_nest();
+bool in_array(const Range& r, int len);
+AbsVal pop_val(vector<AbsVal>& stk);
+void need_type(const AbsVal& v, bool isInt);
+Range var_range(TknKind kd, int symNbr);
+void set_range(TknKind kd, int symNbr, const Range& r);
+Range r_binary(TknKind op, const Range& a, const Range& b);
+Range r_const(double d);
+Range r_int(double lo, double hi);
+Range r_double();
+Range r_join(const Range& a, const Range& b);
+bool r_same(const Range& a, const Range& b);
+bool r_int32(const Range& r);
+bool is_intVar(TknKind kd, int symNbr);
+void find_pure();
+bool fnc_isolated(int fncNbr);
+bool locals_assigned(int fncNbr);
+void find_assigned();
+void assigned_codes(int top, int end);
+void assigned_flow(int top, int end, vector<char>& known);
+int var_key(const CodeSet& cd);
+bool join_assigned(vector<unsigned long long>& dst, const vector<unsigned long long>& src);
+int fnc_end(int fncNbr);
+
+/* peri_opt.cpp (OPTIMIZATION OF THE INTERNAL CODE) */
+bool inline_calls();
+bool inlinable(int fncNbr);
+void inline_body(int caller, int callee);
+int inl_local(int caller, int callee, int sym);
+void inl_line(int line);
+
+/* peri_jit.cpp (NATIVE CODE) */
+void jit_compile();
+void tier_up(int fncNbr);
+void tier_report();
+bool jit_function(int fncNbr);
+bool jit_supported(int adrs, const CodeSet& cd);
+void jit_code(int adrs, const CodeSet& cd, int dp);
+void jit_selfTail(int fncNbr, int dp);
+int jit_local(int adrs);
+int jit_slot(int k);
+void jit_bool(int slot);
+void jit_truth(int slot);
+void jit_load(int slot);
+void jit_store(int slot);
+void jit_sse(const char *op, int reg, int slot);
+void jit_call(void *f);
+void jit_rel32(int adrs);
+void jit_bytes(const char *s, int len);
+void jit_int32(int n);
+void jit_int64(long long n);
+void jit_divError(int adrs);
+
+/* peri_emit.cpp (TRANSLATION INTO C++) */
+void emit_cpp(const char *fname);
+void emit_function(ostream& out, int fncNbr);
+void emit_body(ostream& out, int top, int end, int entry, int args, int fncNbr);
+void emit_code(ostream& out, int adrs, const CodeSet& cd, int dp, int fncNbr);
+string emit_fncName(int fncNbr);
+string emit_params(int fncNbr);
+string emit_op(TknKind kd);
+string emit_dbl(double d);
+string emit_str(const char *s);
+
+/* peri_cache.cpp (CACHE OF THE CONVERTED PROGRAM) */
+bool load_cache(const char *fname);
+void save_cache(const char *fname);
+unsigned long long source_hash(const char *fname);
+void put_bytes(const char *s, int len);
+void put_int(int n);
+void put_str(const string& s);
+void put_table(const vector<SymTbl>& tbl);
+bool get_bytes(char *s, int len);
+int get_int();
+int get_count();
+unsigned long long get_u64();
+string get_str();
+bool get_table(vector<SymTbl>& tbl);
+
+/* peri_misc.cpp (ERROR HANDLING, INPUT AND OUTPUT) */
 string dbl_to_s(double d);
 string err_msg(const string& a, const string& b);
 void err_exit(Tobj a="\1", Tobj b="\1", Tobj c="\1", Tobj d="\1");
 void prt(Tobj a="\1", Tobj b="\1", Tobj c="\1", Tobj d="\1", Tobj e="\1", Tobj f="\1", Tobj g="\1", Tobj h="\1");
+void out_str(const char *s, int len);
+void out_dbl(double d);
+void out_nl();
+void out_flush();
+double in_line();
+int read_array(Value *mem, int len, const char *fname);
+bool in_token(const char **s, const char **e);
+bool in_fill();
+double str_to_dbl(const char *s, const char *e);
+bool num_token(const char *s, const char *e, double& d);
+int load_array(Value *mem, int len, const char *fname, int fmt);
+int store_array(Value *mem, int len, const char *fname, int fmt);
+double elm_get(const char *p, int fmt);
+void elm_put(char *p, double d, int fmt);
 
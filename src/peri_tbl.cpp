@@ -23,6 +23,9 @@
 vector<SymTbl> Gtable;   //  Global Symbols Table
 vector<SymTbl> Ltable;   //  Local  Symbols Table
 int startLtable;         //  Start position for LST
+unordered_map<string,int> gIndex;      //  Table No. of each global name
+unordered_map<string,int> lIndex;      //  Table No. of each local name of the function being converted
+unordered_map<string,int> localNames;  //  Every local name so far (it may not be a function name)
 
 
 /* Registration of symbol table */
@@ -45,7 +48,7 @@ int enter(SymTbl& tb, SymKind kind) {
   if (n != -1) err_exit(" : ", tb.name);
 
   //  Setting adress
-  if (kind == fncId) tb.adrs = get_lineNo();                      // Line that function starts
+  if (kind == fncId) tb.adrs = 0;                                 // Fixed when the definition is converted
   else {
     if (isLocal) { tb.adrs = localAdrs; localAdrs += mem_size; }  //  Local
     else {
@@ -54,8 +57,8 @@ int enter(SymTbl& tb, SymKind kind) {
     }
   }
 
-  if (isLocal) { n = Ltable.size(); Ltable.push_back(tb); }       //  Local
-  else         { n = Gtable.size(); Gtable.push_back(tb); }       //  Global
+  if (isLocal) { n = Ltable.size(); Ltable.push_back(tb); lIndex[tb.name] = n; ++localNames[tb.name]; }   //  Local
+  else         { n = Gtable.size(); Gtable.push_back(tb); gIndex[tb.name] = n; }                        //  Global
   return n;                                                       //  Location of Registrated
 }
 
@@ -63,6 +66,7 @@ int enter(SymTbl& tb, SymKind kind) {
 /* Start of Local Symbols Table */
 void set_startLtable() {
   startLtable = Ltable.size();
+  lIndex.clear();
 }
 
 
@@ -77,18 +81,18 @@ bool is_localName(const string& name, SymKind kind) {
 
 
 /* Searching name */
+/* The names are hashed : a global one is kept in gIndex, a local one in lIndex until the next function */
 int searchName(const string& s, int mode) {
+  unordered_map<string,int>::iterator it;
   int n;
   switch (mode) {
   case 'G':                                             //  Searching in Global Symbols Table
-      for (n = 0; n < (int)Gtable.size(); n++) {
-        if (Gtable[n].name == s) return n;
-        }
+      it = gIndex.find(s);
+      if (it != gIndex.end()) return it->second;
       break;
   case 'L':                                             //  Searching in Local Symbols Table
-      for (n = startLtable; n < (int)Ltable.size(); n++) {
-        if (Ltable[n].name == s) return n;
-      }
+      it = lIndex.find(s);
+      if (it != lIndex.end()) return it->second;
       break;
   case 'F':                                             //  Searching in Function Name 
       n = searchName(s, 'G');
@@ -104,6 +108,7 @@ int searchName(const string& s, int mode) {
 }
 
 vector<SymTbl>::iterator tableP(const CodeSet& cd) {
-  if (cd.kind == Lvar) return Ltable.begin() + cd.symNbr;             /* Lvar */
-  return Gtable.begin() + cd.symNbr;                            /* Gvar Fcall */
+  if (cd.kind == Lvar || cd.kind == Lset || cd.kind == Ladrs || cd.kind == Lread || cd.kind == Lwrite)
+    return Ltable.begin() + cd.symNbr;                          /* Lvar Lset Ladrs Lread Lwrite */
+  return Gtable.begin() + cd.symNbr;                            /* Gvar Gset Gadrs Gread Gwrite Fcall */
 }
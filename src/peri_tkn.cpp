@@ -18,6 +18,15 @@
 /* Header File */
 #include "peri.h"
 #include "peri_prot.h"
+#include <charconv>
+
+#if defined(__unix__) || defined(__APPLE__)
+#define SRC_MMAP
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
 
 
 /* Managing lexical and typographical correspondence */
@@ -38,6 +47,8 @@ KeyWord KeyWdTbl[] = {
   {"print"  , Print }, {"println", Println},
   {"option" , Option}, {"input"  , Input  },
   {"toint"  , Toint }, {"exit"   , Exit   },
+  {"flush"  , Flush }, {"readarray", Readarray},
+  {"loadarray", Loadarray}, {"storearray", Storearray},
   {"("  , Lparen    }, {")"  , Rparen   },
   {"["  , Lbracket  }, {"]"  , Rbracket },
   {"+"  , Plus      }, {"-"  , Minus    },
@@ -54,17 +65,24 @@ KeyWord KeyWdTbl[] = {
 };
 
 
+/* Define */
+#define KW_HASH 256     //  Size of the hash table of the keywords
+
+
 /* Declaration of variables */
 int srcLineno;          //  Source line No.
 TknKind ctyp[256];      //  Array of character type tables
+int kwHash[KW_HASH];    //  Index of KeyWdTbl by kw_hash()  -1 : no keyword
+bool blankCh[256];      //  Blank characters (as isspace)
+bool identCh[256];      //  Characters after the first one of a name
+long long tokenCnt;     //  Number of tokens read
+bool lexRpt_F;          //  If TRUE, report the front end (--lex-report)
 char *token_p;          //  1 Text acquisition with text location
 bool endOfFile_F;       //  End-of-file flag
-char buf[LIN_SIZ+5];    //  Location of source loading
-ifstream fin;           //  Input Stream
-
-
-/* Define */
-#define MAX_LINE 2000   //  Maximum number of program lines
+vector<char> srcBuf;    //  Source read from the standard input or given in memory
+char *srcMap;           //  Source file mapped into memory  NULL : in srcBuf
+size_t srcMapSiz;       //  Size of the mapping
+char *src_p, *srcEnd;   //  Top of the next line, end of the source
 
 
 /* Setting the character type table */
@@ -87,35 +105,85 @@ void initChTyp() {
   ctyp['?']  = Ifsub;     ctyp['=']  = Assign;
   ctyp['\\'] = IntDivi;   ctyp[',']  = Comma;
   ctyp['\"'] = DblQ;
-  
+
+  for (i = 0; i < 256; i++) {
+    blankCh[i] = isspace(i) != 0;
+    identCh[i] = ctyp[i] == Letter || ctyp[i] == Digit;
+  }
+  for (i = 0; i < KW_HASH; i++) kwHash[i] = -1;
+  for (i = 0; KeyWdTbl[i].keyKind != END_KeyList; i++) kwHash[kw_hash(KeyWdTbl[i].keyName)] = i;
+
 }
 
 
 /* Opening File */
+/* The whole source is put in memory : a file is mapped (privately, so the lines can be ended with
+   '\0' where they are), and "-" reads the standard input. */
 void fileOpen(char *fname) {
+  istreambuf_iterator<char> top, end;
+  ifstream fin;
+
+  if (strcmp(fname, "-") == 0) {              //  Standard input
+    top = istreambuf_iterator<char>(cin);
+    srcBuf.assign(top, end);
+    memOpen(srcBuf.empty() ? NULL : &srcBuf[0], srcBuf.size());
+    return;
+  }
+#ifdef SRC_MMAP
+  struct stat st;
+  int fd = open(fname, O_RDONLY);
+  void *p;
+
+  if (fd >= 0 && fstat(fd, &st) == 0 && S_ISREG(st.st_mode) && st.st_size > 0) {
+    p = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (p != MAP_FAILED) {
+      close(fd);
+      memOpen((char *)p, st.st_size);
+      srcMap = (char *)p; srcMapSiz = st.st_size;
+      return;
+    }
+  }
+  if (fd >= 0) close(fd);
+#endif
+  fin.open(fname, ios::in | ios::binary);     //  Read when it cannot be mapped
+  if (!fin) { cout << fname << "cannot open.(File)\n"; exit(1); }
+  top = istreambuf_iterator<char>(fin);
+  srcBuf.assign(top, end);
+  memOpen(srcBuf.empty() ? NULL : &srcBuf[0], srcBuf.size());
+}
+
+
+/* Source given in memory (it is written on to end the lines) */
+void memOpen(char *text, size_t len) {
   srcLineno = 0;
   endOfFile_F = false;
-  fin.open(fname);
-  if (!fin) { cout << fname << "cannot open.(File)\n"; exit(1); }
+  srcMap = NULL;
+  src_p = text; srcEnd = text + len;
 }
 
 
 /* Get next line */
 void nextLine() {
-  string s;
+  char *eol;
 
   if (endOfFile_F) return;
-  fin.getline(buf, LIN_SIZ+5);    //  Get a line
-  if (fin.eof()) {                //  End of file
-    fin.clear(); fin.close();     //  "clear" is ready to re-open
-    endOfFile_F = true; return;   
+  eol = (char *)memchr(src_p, '\n', srcEnd - src_p);
+  if (eol == NULL) {                          //  End of source (a last line without a newline is not read)
+    if (srcMap != NULL) munmap_src();
+    endOfFile_F = true; return;
   }
+  *eol = '\0'; token_p = src_p; src_p = eol + 1;
+  ++srcLineno;
+  reserve_codebuf(eol - token_p);             //  Any length of line
+}
+
 
-  if (strlen(buf) > LIN_SIZ)
-    err_exit("The program should be written within ", LIN_SIZ, " characters per line.");
-  if (++srcLineno > MAX_LINE)
-    err_exit("The program is over ", MAX_LINE, " lines long.");
-  token_p = buf;                  //  Pointer for token analysis is placed at the top of buf
+/* Release the mapped source */
+void munmap_src() {
+#ifdef SRC_MMAP
+  munmap(srcMap, srcMapSiz);
+#endif
+  srcMap = NULL;
 }
 
 
@@ -128,39 +196,50 @@ Token nextLine_tkn() {
 
 /* Define */
 #define CH (*token_p)
+#define UCH (*(unsigned char *)token_p)
 #define C2 (*(token_p+1))
 #define NEXT_CH()  ++token_p
 
 
 /* Next token */
+/* The text of the token is a view into the source in memory, so nothing is copied.  Each run of
+   blanks, letters and digits is scanned on the character class tables. */
 Token nextTkn() {
+  const char *top;
   TknKind kd;
-  string txt = "";
+  double d;
+  string_view txt;
 
   if (endOfFile_F) return Token(EofProg);            //  End of file
-  while (isspace(CH)) NEXT_CH();                     //  Read away the blanks
+  while (blankCh[UCH]) NEXT_CH();                    //  Read away the blanks
   if (CH == '\0')  return Token(EofLine);            //  End of line
+  ++tokenCnt;
 
-  switch (ctyp[CH]) {
+  top = token_p;
+  switch (ctyp[UCH]) {
   case Doll: case Letter:
-    txt += CH; NEXT_CH();
-    while (ctyp[CH]==Letter || ctyp[CH]==Digit) { txt += CH; NEXT_CH(); }
+    NEXT_CH();
+    while (identCh[UCH]) NEXT_CH();
+    txt = string_view(top, token_p - top);
     break;
   case Digit:                                         //  Numerical constant
     kd = IntNum;
-    while (ctyp[CH] == Digit)   { txt += CH; NEXT_CH(); }
-    if (CH == '.') { kd = DblNum; txt += CH; NEXT_CH(); }
-    while (ctyp[CH] == Digit)   { txt += CH; NEXT_CH(); }
-    return Token(kd, txt, atof(txt.c_str()));         //  "IntNum" is also stored as a double type
+    while (ctyp[UCH] == Digit) NEXT_CH();
+    if (CH == '.') { kd = DblNum; NEXT_CH(); }
+    while (ctyp[UCH] == Digit) NEXT_CH();
+    if (from_chars(top, token_p, d).ec == errc::result_out_of_range) d = HUGE_VAL;
+    return Token(kd, string_view(top, token_p - top), d);   //  "IntNum" is also stored as a double type
   case DblQ:                                          //  String constant
-    NEXT_CH();
-    while (CH!='\0' && CH!='"') { txt += CH; NEXT_CH(); }
+    top = ++token_p;
+    while (CH!='\0' && CH!='"') NEXT_CH();
+    txt = string_view(top, token_p - top);
     if (CH == '"') NEXT_CH(); else err_exit("String literal is not closed.");
     return Token(String, txt);
   default:
     if (CH=='/' && C2=='/') return Token(EofLine);    //  Comments
-    if (is_ope2(CH, C2)) { txt += CH; txt += C2; NEXT_CH(); NEXT_CH(); }
-    else                 { txt += CH; NEXT_CH(); }
+    if (is_ope2(CH, C2)) { NEXT_CH(); NEXT_CH(); }
+    else                 NEXT_CH();
+    txt = string_view(top, token_p - top);
   }
   kd = get_kind(txt);                                 //  Set the kind
 
@@ -169,6 +248,16 @@ Token nextTkn() {
 }
 
 
+/* Report of the front end (--lex-report) */
+void lex_report(double sec) {
+  cerr << "Lexer report" << endl;
+  cerr << "  lines : " << srcLineno << endl;
+  cerr << "  tokens : " << tokenCnt << endl;
+  cerr << "  conversion : " << sec * 1000 << " ms" << endl;
+  if (sec > 0) cerr << "  tokens/s : " << (long long)(tokenCnt / sec) << endl;
+}
+
+
 /* TRUE if 2 character operand */
 bool is_ope2(char c1, char c2) {
   char s[] = "    ";
@@ -179,19 +268,25 @@ bool is_ope2(char c1, char c2) {
 
 
 /* Setting kind of tokens */
-TknKind get_kind(const string& s) {
-  for (int i=0; KeyWdTbl[i].keyKind != END_KeyList; i++) {
-    if (s == KeyWdTbl[i].keyName) return KeyWdTbl[i].keyKind;
-  }
-  if (ctyp[s[0]]==Letter || ctyp[s[0]]==Doll) return Ident;
-  if (ctyp[s[0]] == Digit)  return DblNum;
+TknKind get_kind(string_view s) {
+  int k = kwHash[kw_hash(s)];
+
+  if (k != -1 && s == KeyWdTbl[k].keyName) return KeyWdTbl[k].keyKind;
+  if (ctyp[(unsigned char)s[0]]==Letter || ctyp[(unsigned char)s[0]]==Doll) return Ident;
+  if (ctyp[(unsigned char)s[0]] == Digit)  return DblNum;
   return Others;   // nothing ...
 }
 
 
+/* Hash of a keyword : the constants are chosen so that no two keywords of KeyWdTbl collide */
+int kw_hash(string_view s) {
+  return (s.size() * 8 + (unsigned char)s[0] * 13 + (unsigned char)s[s.size() - 1]) % KW_HASH;
+}
+
+
 /* Getting token with confirmation */
 Token chk_nextTkn(const Token& tk, int kind2) {
-  if (tk.kind != kind2) err_exit(err_msg(tk.text, kind_to_s(kind2)));
+  if (tk.kind != kind2) err_exit(err_msg(string(tk.text), kind_to_s(kind2)));
   return nextTkn();
 }
 
@@ -227,5 +322,5 @@ string kind_to_s(const CodeSet& cd) {
 /* Line No. being read or executed */
 int get_lineNo() {
   extern int Pc;
-  return (Pc == -1) ? srcLineno : Pc;   //  Analyzing : Executing
+  return (Pc == -1) ? srcLineno : adrs_to_lineNo(Pc);   //  Analyzing : Executing
 }
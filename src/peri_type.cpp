@@ -0,0 +1,683 @@
+/********************************************************************************************************
+ *
+ *      PROJECT NAME    :   ASMI Demo Contest 2022
+ *
+ *      FILE NAME       :   peri_type.cpp
+ *
+ *      OUTLINE         :   Analysis of the internal code (type inference, pure functions, definite assignment)
+ *
+ *      REQUIRED FILES  :   peri.h, peri_prot.h
+ *
+ *      EDITOR : Taichi KATO,   Advanced Sensing & Machine Intelligence Group,  Chukyo Univ.
+ *
+ *      LAST UPDATED : Apl. 17, 2022
+ *
+ *      Copyright © 2022 Taichi KATO. All rights reserved.
+ *
+*********************************************************************************************************/
+/* Header File */
+#include "peri.h"
+#include "peri_prot.h"
+
+
+/* Define */
+#define INT_LIMIT 9007199254740992.0    //  2^53 : Integers up to here are exact in double
+#define INT32_LO  -2147483648.0         //  Range of the int cast by % , \ and toint
+#define INT32_HI   2147483647.0
+#define GROW_MAX  4                     //  A range that grows more times than this is widened to double
+#define ASG_NONE  0                     //  assigned_flow() : not a code of a variable, or not reached
+#define ASG_NO    1                     //  The variable may not have been assigned
+#define ASG_YES   2                     //  The variable has surely been assigned
+#define ASG_BUDGET 5.0e8                //  Bits of states assigned_flow() may hold
+
+
+vector<Range> gRange, lRange;           //  Range of each variable (Gtable / Ltable)
+vector<int>   gGrow,  lGrow;            //  Times the range of the variable has grown
+vector< vector<AbsVal> > entryStk;      //  Operand stack before each code
+vector<char>  visited;                  //  The code has been followed in this pass
+vector<char>  intCode;                  //  The code works on int64 (or toint needs no code)
+vector<char>  dblResult;                //  The int64 value made by the code is converted to double
+vector<char>  safeIdx;                  //  The index of the array element is surely within the array
+vector<int>   forTop;                   //  ForChk of the innermost 'for' around each code, -1 if none
+bool rangeChanged;                      //  A range has changed in this pass
+bool finalPass;                         //  Setting intCode and dblResult
+vector<char>  pureFnc;                  //  The function is pure (by the symbol table No.)
+vector<char>  initVar;                  //  The variable of the code has surely been assigned
+extern vector<char> intercode;
+extern vector<SymTbl> Gtable;
+extern vector<SymTbl> Ltable;
+extern vector<double> nbrLITERAL;
+extern char *code_ptr;
+extern int startPc;
+
+
+/* Type Inference */
+/* The range of a value is worked out for every variable and every value on the operand stack.
+   A value proved to be always an integer within +-2^53 is held as int64 : the result of each
+   operation is the same as in double, so only the representation changes.  Everything else,
+   and anything unknown, is double. */
+void infer_types() {
+  int n;
+
+  gRange.assign(Gtable.size(), Range()); gGrow.assign(Gtable.size(), 0);
+  lRange.assign(Ltable.size(), Range()); lGrow.assign(Ltable.size(), 0);
+  for (n = 0; n < (int)Gtable.size(); n++) {            //  Arrays are filled with 0 at first
+    if (Gtable[n].aryLen != 0) gRange[n] = r_int(0, 0);
+  }
+  for (n = 0; n < (int)Ltable.size(); n++) {
+    if (Ltable[n].aryLen != 0) lRange[n] = r_int(0, 0);
+  }
+  intCode.assign(intercode.size(), 0);
+  dblResult.assign(intercode.size(), 0);
+  safeIdx.assign(intercode.size(), 0);
+  for_nest();
+  entryStk.assign(intercode.size(), vector<AbsVal>());
+
+  for (finalPass = false; ; ) {         //  Until no range changes, then once more to set the types
+    rangeChanged = false;
+    visited.assign(intercode.size(), 0);
+    infer_region(0, vector<AbsVal>());
+    infer_region(startPc, vector<AbsVal>());
+    for (n = 0; n < (int)Gtable.size(); n++) {
+      if (Gtable[n].nmKind == fncId) infer_region(Gtable[n].adrs, param_stack(n));
+    }
+    if (finalPass) break;
+    if (!rangeChanged) finalPass = true;
+  }
+}
+
+
+/* Arguments on the stack at the entry of the function */
+vector<AbsVal> param_stack(int fncNbr) {
+  vector<AbsVal> st(Gtable[fncNbr].args);
+
+  for (int k = 0; k < Gtable[fncNbr].args; k++) st[k].r = lRange[param_sym(fncNbr, k)];
+  return st;
+}
+
+
+/* Local table No. of the k-th argument of the function (the entry stores them in reverse order) */
+int param_sym(int fncNbr, int k) {
+  code_ptr = &intercode[Gtable[fncNbr].adrs + (Gtable[fncNbr].args - 1 - k) * (1 + OPR_SIZ)];
+  return nextCode().symNbr;
+}
+
+
+/* Follow the codes from "adrs" with the operand stack "st" */
+void infer_region(int adrs, const vector<AbsVal>& st) {
+  vector< pair< int, vector<AbsVal> > > branch;         //  Branches left to follow
+  vector<AbsVal> stk;
+  CodeSet cd;
+  int next;
+
+  branch.push_back(make_pair(adrs, st));
+  while (!branch.empty()) {
+    adrs = branch.back().first; stk = branch.back().second; branch.pop_back();
+    for (;;) {
+      if (!join_stack(adrs, stk) && visited[adrs]) break;   //  Nothing new
+      visited[adrs] = 1;
+      code_ptr = &intercode[adrs]; cd = nextCode();
+      next = code_ptr - &intercode[0];
+
+      if (!infer_code(adrs, cd, stk)) break;            //  End of the flow
+      switch (cd.kind) {
+      case Jump: case Func: case ForNext:
+          next = cd.jmpAdrs;
+          break;
+      case JumpF: case JumpT: case ForChk:
+          branch.push_back(make_pair((int)cd.jmpAdrs, stk));
+          break;
+      }
+      adrs = next;
+    }
+  }
+}
+
+
+/* Join the operand stack into the one before the code at "adrs", TRUE if it has changed */
+bool join_stack(int adrs, vector<AbsVal>& stk) {
+  vector<AbsVal>& e = entryStk[adrs];
+  bool changed = false;
+  Range r;
+
+  if (e.size() != stk.size()) { e = stk; return true; }
+  for (int n = 0; n < (int)stk.size(); n++) {
+    r = r_join(e[n].r, stk[n].r);
+    if (!r_same(r, e[n].r)) { e[n].r = r; changed = true; }
+    stk[n].r = r;
+  }
+  return changed;
+}
+
+
+/* Stack effect of one code on the ranges, FALSE if the flow ends */
+bool infer_code(int adrs, const CodeSet& cd, vector<AbsVal>& stk) {
+  AbsVal a, b, v;
+  Range r;
+  bool in;
+  int f, k;
+
+  switch (cd.kind) {
+  case IntNum: case DblNum:
+      r = r_const(cd.dblVal);
+      if (finalPass) intCode[adrs] = r.integer;
+      stk.push_back(AbsVal(r, adrs));
+      break;
+  case Gvar: case Lvar:                                 //  Value of the variable
+      if (tableP(cd)->aryLen != 0) {
+        a = pop_val(stk);                               //  Index
+        if (finalPass) intCode[adrs] = a.r.integer;
+        if (finalPass) safeIdx[adrs] = in_array(a.r, tableP(cd)->aryLen);
+        stk.push_back(AbsVal(var_range(cd.kind, cd.symNbr), adrs));
+      }
+      else stk.push_back(AbsVal(loop_range(adrs, cd), adrs));
+      break;
+  case Gadrs: case Ladrs:                               //  Address of the variable
+      if (tableP(cd)->aryLen != 0) {
+        a = pop_val(stk);
+        if (finalPass) intCode[adrs] = a.r.integer;
+        if (finalPass) safeIdx[adrs] = in_array(a.r, tableP(cd)->aryLen);
+      }
+      v = AbsVal(r_double(), adrs);
+      v.sym = cd.symNbr; v.symKind = (cd.kind == Gadrs) ? Gvar : Lvar;
+      stk.push_back(v);
+      break;
+  case Gset: case Lset:                                 //  Assignment
+      a = pop_val(stk);
+      if (tableP(cd)->aryLen != 0) (void)pop_val(stk);  //  Address of the element
+      else if (!stk.empty() && stk.back().sym == cd.symNbr && stk.back().symKind == (cd.kind == Gset ? Gvar : Lvar))
+        stk.back().r = a.r;                             //  Initial value of 'for', whose address stays on the stack
+      set_range(cd.kind == Gset ? Gvar : Lvar, cd.symNbr, a.r);
+      need_type(a, var_range(cd.kind == Gset ? Gvar : Lvar, cd.symNbr).integer);
+      break;
+  case Plus: case Minus: case Multi: case Divi: case Mod: case IntDivi:
+  case Less: case LessEq: case Great: case GreatEq: case Equal: case NotEq:
+  case And: case Or:
+      b = pop_val(stk); a = pop_val(stk);
+      r = r_binary(cd.kind, a.r, b.r);
+      if (finalPass) intCode[adrs] = r.integer;
+      need_type(a, r.integer); need_type(b, r.integer);
+      stk.push_back(AbsVal(r, adrs));
+      break;
+  case Not: case Uminus:
+      a = pop_val(stk);
+      r = a.r.none ? Range() : r_double();             //  Nothing has reached yet
+      if (a.r.integer && cd.kind == Not) r = r_int(0, 1);
+      if (a.r.integer && cd.kind == Uminus && (a.r.lo > 0 || a.r.hi < 0)) r = r_int(-a.r.hi, -a.r.lo);   //  -0 stays double
+      if (finalPass) intCode[adrs] = r.integer;
+      need_type(a, r.integer);
+      stk.push_back(AbsVal(r, adrs));
+      break;
+  case Toint:                                           //  The result is always int64
+      a = pop_val(stk);
+      in = a.r.integer && a.r.lo >= INT32_LO && a.r.hi <= INT32_HI;
+      if (finalPass) intCode[adrs] = in;                //  No code is needed
+      need_type(a, in);
+      stk.push_back(AbsVal(in ? a.r : r_int(INT32_LO, INT32_HI), in ? a.prod : adrs));
+      break;
+  case Input: case RetVal:
+      stk.push_back(AbsVal(r_double(), adrs));
+      break;
+  case Gread: case Lread: case Gwrite: case Lwrite:     //  The elements in the files are double
+      set_range(cd.kind == Gread || cd.kind == Gwrite ? Gvar : Lvar, cd.symNbr, r_double());
+      stk.push_back(AbsVal(r_double(), adrs));
+      break;
+  case Fcall:                                           //  Arguments go to the parameters
+      f = cd.symNbr;
+      for (k = Gtable[f].args - 1; k >= 0; k--) {
+        a = pop_val(stk);
+        set_range(Lvar, param_sym(f, k), a.r);
+        need_type(a, lRange[param_sym(f, k)].integer);
+      }
+      stk.push_back(AbsVal(r_double(), adrs));
+      break;
+  case Print:
+      a = pop_val(stk);
+      if (finalPass) intCode[adrs] = a.r.integer;
+      break;
+  case JumpF: case JumpT:
+      a = pop_val(stk);
+      if (finalPass) intCode[adrs] = a.r.integer;
+      break;
+  case Pop:
+      (void)pop_val(stk);
+      break;
+  case Dup:
+      stk.push_back(stk.back());
+      break;
+  case Return:
+      a = pop_val(stk);
+      need_type(a, false);                              //  The return value is double
+      return false;
+  case RetSet:                                          //  The value stays as double
+      a = pop_val(stk);
+      need_type(a, false);
+      stk.push_back(AbsVal(r_double(), adrs));
+      break;
+  case ForChk: case ForNext:                            //  Stack : address, last value, step
+      infer_for(adrs, cd, stk);
+      break;
+  case Exit: case EofProg:
+      return false;
+  }
+  return true;
+}
+
+
+/* Loop of 'for' */
+/* Unless the body stores to the control variable, it stays between the initial value and last + step. */
+void infer_for(int adrs, const CodeSet& cd, vector<AbsVal>& stk) {
+  AbsVal& var = stk[stk.size()-3];
+  AbsVal& last = stk[stk.size()-2];
+  AbsVal& step = stk[stk.size()-1];
+  Range vr, r;
+  bool ok;
+
+  if (var.sym == -1) return;
+  vr = var_range(var.symKind, var.sym);
+  ok = last.r.integer && step.r.integer;                //  Otherwise the control variable is double
+
+  if (cd.kind == ForNext) {
+    if (!ok || vr.none || for_stored(cd.jmpAdrs, adrs, var)) r = r_double();
+    else if (step.r.lo >= 0) r = r_int(vr.lo, max(vr.hi, last.r.hi + step.r.hi));
+    else if (step.r.hi <  0) r = r_int(min(vr.lo, last.r.lo + step.r.lo), vr.hi);
+    else                     r = r_double();
+    set_range(var.symKind, var.sym, r);
+  }
+  else if (!ok && !last.r.none && !step.r.none) set_range(var.symKind, var.sym, r_double());
+
+  vr = var_range(var.symKind, var.sym);
+  if (finalPass) intCode[adrs] = vr.integer;
+  need_type(last, vr.integer); need_type(step, vr.integer);
+}
+
+
+/* TRUE if the body of the loop (from the ForChk at "top" to the ForNext at "end") may store to the variable */
+bool for_stored(int top, int end, const AbsVal& var) {
+  CodeSet cd;
+  SymTbl *p = (var.symKind == Gvar) ? &Gtable[var.sym] : &Ltable[var.sym];
+
+  if (p->aryLen != 0) return true;                      //  Elements are not told apart
+  for (code_ptr = &intercode[top]; code_ptr < &intercode[end]; ) {
+    cd = nextCode();
+    if (cd.kind == Fcall && var.symKind == Gvar && p->name[0] == '$') return true;   //  Functions see $ variables
+    if ((cd.kind == Gset || cd.kind == Gadrs) && var.symKind == Gvar && cd.symNbr == var.sym) return true;
+    if ((cd.kind == Lset || cd.kind == Ladrs) && var.symKind == Lvar && cd.symNbr == var.sym) return true;
+  }
+  return false;
+}
+
+
+/* Range of the variable read by the code at "adrs" */
+/* In the body of a 'for' that does not store to its control variable, the variable lies between
+   the initial value and the last value, for it only moves by the step and ForChk has just let it in. */
+Range loop_range(int adrs, const CodeSet& cd) {
+  Range r = var_range(cd.kind, cd.symNbr);
+  int f;
+
+  if (!r.integer) return r;
+  for (f = forTop[adrs]; f != -1; f = forTop[f]) {
+    vector<AbsVal>& e = entryStk[f];
+    if (e.size() < 3) continue;
+    AbsVal& var = e[e.size()-3];
+    AbsVal& last = e[e.size()-2];
+    AbsVal& step = e[e.size()-1];
+    if (var.sym != cd.symNbr || var.symKind != cd.kind) continue;
+
+    code_ptr = &intercode[f];
+    if (!last.r.integer || !step.r.integer || for_stored(f, nextCode().jmpAdrs, var)) break;
+    if (step.r.lo >= 0) {
+      r = r_int(r.lo, min(r.hi, last.r.hi));
+      if (var.r.integer) r = r_int(max(r.lo, var.r.lo), r.hi);
+    }
+    else if (step.r.hi < 0) {
+      r = r_int(max(r.lo, last.r.lo), r.hi);
+      if (var.r.integer) r = r_int(r.lo, min(r.hi, var.r.hi));
+    }
+    break;
+  }
+  return r;
+}
+
+
+/* Innermost 'for' around each code ; the body of a 'for' lies between its ForChk and the exit */
+void for_nest() {
+  vector<int> open, exit;               //  ForChk and exit of the loops around the code
+  CodeSet cd;
+  int adrs;
+
+  forTop.assign(intercode.size() + 1, -1);
+  for (code_ptr = &intercode[0]; code_ptr < &intercode[0] + intercode.size(); ) {
+    adrs = code_ptr - &intercode[0];
+    cd = nextCode();
+    while (!exit.empty() && adrs >= exit.back()) { open.pop_back(); exit.pop_back(); }
+    if (!open.empty()) forTop[adrs] = open.back();
+    if (cd.kind == ForChk) { open.push_back(adrs); exit.push_back(cd.jmpAdrs); }
+  }
+}
+
+
+/* TRUE if every index in the range is an element of the array of "len" elements */
+bool in_array(const Range& r, int len) {
+  return r.integer && r.lo >= 0 && r.hi < len;
+}
+
+
+/* Pop the operand stack */
+AbsVal pop_val(vector<AbsVal>& stk) {
+  AbsVal v = stk.back();
+  stk.pop_back();
+  return v;
+}
+
+
+/* The value is used as int64 (isInt) or double ; an int64 value used as double is converted where it is made */
+void need_type(const AbsVal& v, bool isInt) {
+  if (finalPass && v.r.integer && !isInt && v.prod >= 0) dblResult[v.prod] = 1;
+}
+
+
+/* Range of the variable */
+Range var_range(TknKind kd, int symNbr) {
+  return (kd == Gvar) ? gRange[symNbr] : lRange[symNbr];
+}
+
+
+/* Join the value into the range of the variable, which is widened to double if it keeps growing */
+void set_range(TknKind kd, int symNbr, const Range& r) {
+  Range& v  = (kd == Gvar) ? gRange[symNbr] : lRange[symNbr];
+  int& grow = (kd == Gvar) ? gGrow[symNbr]  : lGrow[symNbr];
+  Range j = r_join(v, r);
+
+  if (r_same(j, v)) return;
+  if (++grow > GROW_MAX) j = r_double();
+  v = j; rangeChanged = true;
+}
+
+
+/* Range of the result of a binary operation ; int64 only if both are int64 and the result stays exact */
+Range r_binary(TknKind op, const Range& a, const Range& b) {
+  double p1, p2, p3, p4, m;
+
+  if (a.none || b.none) return Range();
+  if (!a.integer || !b.integer) return r_double();
+
+  switch (op) {
+  case Plus:    return r_int(a.lo + b.lo, a.hi + b.hi);
+  case Minus:   return r_int(a.lo - b.hi, a.hi - b.lo);
+  case Multi:
+      if ((a.lo <= 0 && 0 <= a.hi && b.lo < 0) || (b.lo <= 0 && 0 <= b.hi && a.lo < 0))
+        return r_double();                              //  0 * -n is -0 in double
+      p1 = a.lo * b.lo; p2 = a.lo * b.hi; p3 = a.hi * b.lo; p4 = a.hi * b.hi;
+      return r_int(min(min(p1, p2), min(p3, p4)), max(max(p1, p2), max(p3, p4)));
+  case Mod:                                             //  (int)a % (int)b
+      if (!r_int32(a) || !r_int32(b)) return r_double();
+      m = max(fabs(b.lo), fabs(b.hi)) - 1;
+      return r_int(max(min(0.0, a.lo), -m), min(max(0.0, a.hi), m));
+  case IntDivi:                                         //  (int)a / (int)b
+      if (!r_int32(a) || !r_int32(b)) return r_double();
+      m = max(fabs(a.lo), fabs(a.hi));
+      return r_int(-m, m);
+  case Less: case LessEq: case Great: case GreatEq: case Equal: case NotEq:
+  case And: case Or:
+      return r_int(0, 1);
+  default:                                              //  Divi
+      return r_double();
+  }
+}
+
+
+/* Range of a literal */
+Range r_const(double d) {
+  if (d != floor(d) || (d == 0 && signbit(d))) return r_double();   //  Fractions and -0 are double
+  return r_int(d, d);
+}
+
+
+/* Integer range, or double if it may not be exact */
+Range r_int(double lo, double hi) {
+  Range r;
+  if (lo < -INT_LIMIT || hi > INT_LIMIT) return r_double();
+  r.none = false; r.integer = true; r.lo = lo; r.hi = hi;
+  return r;
+}
+
+
+/* Any double value */
+Range r_double() {
+  Range r;
+  r.none = false;
+  return r;
+}
+
+
+/* Join of two ranges */
+Range r_join(const Range& a, const Range& b) {
+  if (a.none) return b;
+  if (b.none) return a;
+  if (!a.integer || !b.integer) return r_double();
+  return r_int(min(a.lo, b.lo), max(a.hi, b.hi));
+}
+
+
+/* TRUE if the ranges are the same */
+bool r_same(const Range& a, const Range& b) {
+  if (a.none || b.none)       return a.none == b.none;
+  if (!a.integer || !b.integer) return a.integer == b.integer;
+  return a.lo == b.lo && a.hi == b.hi;
+}
+
+
+/* TRUE if the range is within int */
+bool r_int32(const Range& r) {
+  return r.lo >= INT32_LO && r.hi <= INT32_HI;
+}
+
+
+/* TRUE if the variable is held as int64 */
+bool is_intVar(TknKind kd, int symNbr) {
+  if (kd == Gvar || kd == Gset || kd == Gadrs) return gRange[symNbr].integer;
+  return lRange[symNbr].integer;
+}
+
+
+/* Pure Functions */
+/* A function is pure if it uses only its parameters and local scalars, assigns each local before
+   reading it, does no input or output, and calls only pure functions.  Its value then depends
+   only on its arguments. */
+void find_pure() {
+  bool changed;
+  CodeSet cd;
+  int n, end;
+
+  pureFnc.assign(Gtable.size(), 0);
+  for (n = 0; n < (int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind == fncId) pureFnc[n] = fnc_isolated(n) && locals_assigned(n);
+  }
+  do {                                                  //  Calls to impure functions
+    changed = false;
+    for (n = 0; n < (int)Gtable.size(); n++) {
+      if (!pureFnc[n]) continue;
+      end = fnc_end(n);
+      for (code_ptr = &intercode[Gtable[n].adrs]; code_ptr < &intercode[end]; ) {
+        cd = nextCode();
+        if (cd.kind == Fcall && !pureFnc[cd.symNbr]) { pureFnc[n] = 0; changed = true; break; }
+      }
+    }
+  } while (changed);
+}
+
+
+/* TRUE if the function touches nothing but its own scalar variables */
+bool fnc_isolated(int fncNbr) {
+  int end = fnc_end(fncNbr);
+  CodeSet cd;
+
+  for (code_ptr = &intercode[Gtable[fncNbr].adrs]; code_ptr < &intercode[end]; ) {
+    cd = nextCode();
+    switch (cd.kind) {
+    case Gvar: case Gset: case Gadrs:                   //  $ variables
+    case Print: case String: case Println: case Flush: case Input: case Gread: case Lread: case Gwrite: case Lwrite:
+    case Exit:
+        return false;
+    case Lvar: case Lset: case Ladrs:
+        if (Ltable[cd.symNbr].aryLen != 0) return false;   //  Elements keep values of former calls
+        break;
+    default:
+        break;
+    }
+  }
+  return true;
+}
+
+
+/* TRUE if every local variable of the function is assigned before it is read, on every path */
+bool locals_assigned(int fncNbr) {
+  int top = Gtable[fncNbr].adrs, end = fnc_end(fncNbr), adrs;
+  vector<char> known;
+  CodeSet cd;
+
+  assigned_flow(top, end, known);
+  for (code_ptr = &intercode[top]; code_ptr < &intercode[end]; ) {
+    adrs = code_ptr - &intercode[0];
+    cd = nextCode();
+    if (cd.kind == Lvar && known[adrs - top] == ASG_NO) return false;
+  }
+  return true;
+}
+
+
+/* Definite Assignment */
+/* A variable gets its type at its first assignment and keeps it, so a variable assigned on every path
+   to a code within the same run of the function (or of the program) needs no check there.  Calls are
+   not followed : what a callee assigns is simply not counted. */
+void find_assigned() {
+  initVar.assign(intercode.size(), 0);
+  assigned_codes(startPc, intercode.size());
+  for (int n = 0; n < (int)Gtable.size(); n++) {
+    if (Gtable[n].nmKind == fncId) assigned_codes(Gtable[n].adrs, fnc_end(n));
+  }
+}
+
+
+/* Set initVar of the codes reached from "top" (up to "end") */
+void assigned_codes(int top, int end) {
+  vector<char> known;
+
+  assigned_flow(top, end, known);
+  for (int n = 0; n < end - top; n++) {
+    if (known[n] == ASG_YES) initVar[top + n] = 1;
+  }
+}
+
+
+/* Whether the variable of each code from "top" (up to "end") has surely been assigned before it */
+/* known[adrs - top] : ASG_YES, ASG_NO, or ASG_NONE (not a code of a variable, or not reached).
+   The state is kept only at the top of each basic block, as bits of the variables the codes use, and
+   it is the intersection where paths meet.  When the blocks times the variables pass ASG_BUDGET,
+   every variable is taken as possibly unassigned, so a huge program is not analyzed in square time. */
+void assigned_flow(int top, int end, vector<char>& known) {
+  vector<CodeSet> cds;                                  //  Codes from "top"
+  vector<int> adrs, codeNo(end - top + 1, -1);          //  Address of each code, its index
+  vector<int> blk, blkOf;                               //  First code of each block, block of each leader
+  vector< vector<unsigned long long> > in;              //  Variables assigned at the top of each block (bits)
+  vector<int> work, var;                                //  Blocks to follow, dense No. of the variable of each code
+  unordered_map<int,int> dense;                         //  Variable (as in var_key()) -> dense No.
+  vector<unsigned long long> st;
+  vector<char> leader;
+  int n, k, b, last, nb, words;
+
+  for (code_ptr = &intercode[top]; code_ptr < &intercode[end]; ) {
+    codeNo[code_ptr - &intercode[top]] = cds.size();
+    adrs.push_back(code_ptr - &intercode[0]); cds.push_back(nextCode());
+    k = var_key(cds.back());
+    if (k != -1 && !dense.count(k)) { n = dense.size(); dense[k] = n; }
+    var.push_back(k == -1 ? -1 : dense[k]);
+  }
+  known.assign(end - top, ASG_NONE);
+  if (cds.empty()) return;
+
+  leader.assign(cds.size() + 1, 0);                     //  Basic blocks
+  leader[0] = 1;
+  for (n = 0; n < (int)cds.size(); n++) {
+    if (is_jump(cds[n].kind) || cds[n].kind == Return || cds[n].kind == Exit || cds[n].kind == EofProg) leader[n+1] = 1;
+    if (is_jump(cds[n].kind) && cds[n].jmpAdrs >= top && cds[n].jmpAdrs < end) leader[codeNo[cds[n].jmpAdrs - top]] = 1;
+  }
+  blkOf.assign(cds.size() + 1, -1);
+  for (n = 0; n < (int)cds.size(); n++) {
+    if (leader[n]) { blkOf[n] = blk.size(); blk.push_back(n); }
+  }
+  blk.push_back(cds.size());
+  nb = blk.size() - 1;
+  words = (dense.size() + 63) / 64;
+  if ((double)nb * words * 64 > ASG_BUDGET) {           //  Too large : nothing is known
+    for (n = 0; n < (int)cds.size(); n++) if (var[n] != -1) known[adrs[n] - top] = ASG_NO;
+    return;
+  }
+
+  in.assign(nb, vector<unsigned long long>());
+  in[0].assign(words, 0);
+  work.push_back(0);
+  while (!work.empty()) {
+    b = work.back(); work.pop_back();
+    st = in[b];
+    for (n = blk[b]; n < blk[b+1]; n++) {
+      if ((cds[n].kind == Gset || cds[n].kind == Lset) && var[n] != -1) st[var[n] / 64] |= 1ULL << (var[n] % 64);
+    }
+    last = blk[b+1] - 1;
+    switch (cds[last].kind) {                           //  Following blocks
+    case Return: case Exit: case EofProg:
+        continue;
+    case Jump: case Func: case ForNext:
+        k = -1;
+        break;
+    default:
+        k = blk[b+1];                                   //  Falls into the next block
+        break;
+    }
+    if (k != -1 && k < (int)cds.size() && join_assigned(in[blkOf[k]], st)) work.push_back(blkOf[k]);
+    if (is_jump(cds[last].kind) && cds[last].jmpAdrs >= top && cds[last].jmpAdrs < end) {
+      k = codeNo[cds[last].jmpAdrs - top];
+      if (join_assigned(in[blkOf[k]], st)) work.push_back(blkOf[k]);
+    }
+  }
+
+  for (b = 0; b < nb; b++) {                            //  The codes of the variables
+    if (in[b].empty()) continue;                        //  Not reached from "top"
+    st = in[b];
+    for (n = blk[b]; n < blk[b+1]; n++) {
+      if (var[n] == -1) continue;
+      known[adrs[n] - top] = (st[var[n] / 64] >> (var[n] % 64) & 1) ? ASG_YES : ASG_NO;
+      if (cds[n].kind == Gset || cds[n].kind == Lset) st[var[n] / 64] |= 1ULL << (var[n] % 64);
+    }
+  }
+}
+
+
+/* Variable of the code for assigned_flow() : the Gtable No., or Gtable.size() + the Ltable No. ; -1 if none */
+int var_key(const CodeSet& cd) {
+  switch (cd.kind) {
+  case Gvar: case Gset: return cd.symNbr;
+  case Lvar: case Lset: return Gtable.size() + cd.symNbr;
+  default:              return -1;
+  }
+}
+
+
+/* Intersection of the assigned variables, TRUE if "dst" has changed */
+bool join_assigned(vector<unsigned long long>& dst, const vector<unsigned long long>& src) {
+  bool changed = false;
+
+  if (dst.empty()) { dst = src; return true; }
+  for (int n = 0; n < (int)dst.size(); n++) {
+    if (dst[n] & ~src[n]) { dst[n] &= src[n]; changed = true; }
+  }
+  return changed;
+}
+
+
+/* Address next to the end of the function (the jumping address of its Func) */
+int fnc_end(int fncNbr) {
+  code_ptr = &intercode[Gtable[fncNbr].adrs - (1 + OPR_SIZ)];
+  return nextCode().jmpAdrs;
+}